@@ -2,6 +2,7 @@
 
 static char * readRomName(byte *cartridgeMemory);
 static void checkHeaderChecksum(byte *cartridgeMemory);
+static size readRamSize(byte *cartridgeMemory);
 
 Cartridge::Cartridge(const char *romFile)
 {
@@ -13,6 +14,7 @@ Cartridge::Cartridge(const char *romFile)
     romName = readRomName(cartridgeMemory);
     cgb = cartridgeMemory[0x0143] == 0x80 || cartridgeMemory[0x0143] == 0xC0;
     sgb = cartridgeMemory[0x0146] == 0x03;
+    ramSize = readRamSize(cartridgeMemory);
     checkHeaderChecksum(cartridgeMemory);
 }
 
@@ -31,6 +33,7 @@ Cartridge::Cartridge(const Cartridge &other)
     romName = readRomName(cartridgeMemory);
     cgb = cartridgeMemory[0x0143] == 0x80 || cartridgeMemory[0x0143] == 0xC0;
     sgb = cartridgeMemory[0x0146] == 0x03;
+    ramSize = readRamSize(cartridgeMemory);
     checkHeaderChecksum(cartridgeMemory);
 }
 
@@ -57,6 +60,7 @@ Cartridge& Cartridge::operator=(const Cartridge &other)
     romName = readRomName(cartridgeMemory);
     cgb = cartridgeMemory[0x0143] == 0x80 || cartridgeMemory[0x0143] == 0xC0;
     sgb = cartridgeMemory[0x0146] == 0x03;
+    ramSize = readRamSize(cartridgeMemory);
     checkHeaderChecksum(cartridgeMemory);
     return *this;
 }
@@ -89,6 +93,16 @@ size Cartridge::getCartridgeMemorySize() const
     return cartridgeMemorySize;
 }
 
+byte Cartridge::getCartridgeType() const
+{
+    return cartridgeMemory[0x0147];
+}
+
+size Cartridge::getRamSize() const
+{
+    return ramSize;
+}
+
 bool Cartridge::isCgbEnabled() const
 {
     return cgb;
@@ -111,6 +125,25 @@ static char * readRomName(byte *cartridgeMemory)
     return romName;
 }
 
+static size readRamSize(byte *cartridgeMemory)
+{
+    switch(cartridgeMemory[0x0149])
+    {
+    case 0x01:
+        return 0x0800;
+    case 0x02:
+        return 0x2000;
+    case 0x03:
+        return 0x8000;
+    case 0x04:
+        return 0x20000;
+    case 0x05:
+        return 0x10000;
+    default:
+        return 0x0000;
+    }
+}
+
 static void checkHeaderChecksum(byte *cartridgeMemory)
 {
     byte x = 0;
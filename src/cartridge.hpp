@@ -14,6 +14,8 @@ public:
     char * getRomName() const;
     byte * getCartridgeMemory() const;
     size getCartridgeMemorySize() const;
+    byte getCartridgeType() const;
+    size getRamSize() const;
     bool isCgbEnabled() const;
     bool isSgbEnabled() const;
 
@@ -21,6 +23,7 @@ private:
     byte *cartridgeMemory;
     size cartridgeMemorySize;
     char *romName;
+    size ramSize;
     bool cgb;
     bool sgb;
 };
@@ -3,4 +3,5 @@
 const char * const GAMEBOY_GAME_EXTENSIONS[] = {".gb", ".gbc", "\0"};
 const unsigned short int GAMEBOY_PROGRAM_COUNTER_START = 0x0100;
 const unsigned short int GAMEBOY_STACK_POINTER_START = 0xFFFE;
-const unsigned char GAHOOD_BOY_MAX_FPS = 30;
\ No newline at end of file
+const unsigned int GAMEBOY_CLOCK_SPEED = 4194304;
+const unsigned int GAMEBOY_CLOCKS_PER_FRAME = 70224; // 154 lines of 456 clocks
\ No newline at end of file
@@ -4,6 +4,7 @@
 extern const char * const GAMEBOY_GAME_EXTENSIONS[];
 extern const unsigned short int GAMEBOY_PROGRAM_COUNTER_START;
 extern const unsigned short int GAMEBOY_STACK_POINTER_START;
-extern const unsigned char GAHOOD_BOY_MAX_FPS;
+extern const unsigned int GAMEBOY_CLOCK_SPEED;
+extern const unsigned int GAMEBOY_CLOCKS_PER_FRAME;
 
 #endif
\ No newline at end of file
@@ -2,9 +2,9 @@
 
 #include "opcode_prefix.hpp"
 
-Cpu::Cpu()
+Cpu::Cpu(const bool cgb)
 {
-    registers.A = 0x00;
+    registers.A = cgb ? 0x11 : 0x00; // Games look for 0x11 to tell they run on a Game Boy Color
     registers.B = 0x00;
     registers.D = 0x00;
     registers.H = 0x00;
@@ -122,6 +122,13 @@ cycle Cpu::processNext(Memory &memory)
 			return LD(memory, registers.programCounter, registers.C);
 		case 0x0F: // RRCA
 			return RRCA(registers.flags, registers.A);
+		case 0x10: // STOP 0
+		{
+			// Only the CGB speed switch is emulated, otherwise it carries on like a NOP
+			registers.programCounter += 0x01;
+			memory.switchSpeed();
+			return 4;
+		}
         case 0x11: // LD DE,d16
             return LD16(memory, registers.programCounter, registers.D, registers.E);
         case 0x12: // LD (DE),A
@@ -34,7 +34,7 @@ class Memory;
 class Cpu
 {
 public:
-    Cpu();
+    Cpu(const bool cgb);
 
     cycle update(Memory &memory);
 
@@ -0,0 +1,229 @@
+#include "display.hpp"
+
+Display::Display(Input &input, const ScaleFilter filter, const byte scaleFactor) : input(input), scaler(filter, scaleFactor)
+{
+	rgbaFrame = (Uint32 *) malloc(160 * 144 * sizeof(Uint32));
+	if (!rgbaFrame)
+	{
+		Gahood::criticalError("Failed to allocate the display frame");
+	}
+	window = NULL;
+	renderer = NULL;
+	background = NULL;
+	shownHash = 0;
+	showingFrame = false;
+	SDL_AtomicSet(&presentedFrames, 0);
+	SDL_AtomicSet(&unchangedFrames, 0);
+	SDL_AtomicSet(&windowVisible, 1);
+	SDL_AtomicSet(&running, 1);
+	presenterThread = NULL;
+#ifdef GAHOOD_BOY_THREADED_PRESENTER
+	presenterThread = SDL_CreateThread(runPresenter, "GahoodBoyPresenter", this);
+	if (!presenterThread)
+	{
+		Gahood::criticalSdlError("Failed to start the presenter thread");
+	}
+#else
+	createWindow();
+#endif
+}
+
+Display::~Display()
+{
+	SDL_AtomicSet(&running, 0);
+	if (presenterThread)
+	{
+		SDL_WaitThread(presenterThread, NULL);
+	}
+	else
+	{
+		destroyWindow();
+	}
+	Gahood::log("Presented %d frames, skipped %d unchanged frames", getPresentedFrameCount(), getUnchangedFrameCount());
+	free(rgbaFrame);
+}
+
+Frame * Display::getBackFrame()
+{
+	return frames.getBackFrame();
+}
+
+void Display::publishFrame()
+{
+	frames.publish();
+}
+
+bool Display::isVisible()
+{
+	return SDL_AtomicGet(&windowVisible) != 0;
+}
+
+void Display::pumpEvents()
+{
+	if (!presenterThread)
+	{
+		presentPending();
+	}
+}
+
+int Display::getPresentedFrameCount()
+{
+	return SDL_AtomicGet(&presentedFrames);
+}
+
+int Display::getUnchangedFrameCount()
+{
+	return SDL_AtomicGet(&unchangedFrames);
+}
+
+int Display::runPresenter(void *display)
+{
+	static_cast<Display *> (display)->presentLoop();
+	return 0;
+}
+
+void Display::presentLoop()
+{
+	// SDL wants the window, its renderer and the event pump on the same thread
+	createWindow();
+	while (SDL_AtomicGet(&running))
+	{
+		if (!presentPending())
+		{
+			// Nothing arrives while hidden, only the events need watching until the window comes back
+			SDL_Delay(isVisible() ? 1 : 10);
+		}
+	}
+	destroyWindow();
+}
+
+bool Display::presentPending()
+{
+	pollEvents();
+	const Frame *frame = frames.acquire();
+	if (!frame)
+	{
+		return false;
+	}
+	present(frame);
+	return true;
+}
+
+void Display::createWindow()
+{
+	const int width = static_cast<int> (scaler.getWidth());
+	const int height = static_cast<int> (scaler.getHeight());
+	window = SDL_CreateWindow("GahoodBoy", 100, 100, width, height, SDL_WINDOW_OPENGL);
+	if (!window)
+	{
+		Gahood::criticalSdlError("Failed to create the window");
+	}
+	// Waiting for vsync only holds up this thread, emulation keeps running
+	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	if (!renderer)
+	{
+		Gahood::criticalSdlError("Failed to create the window renderer");
+	}
+	background = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+	if (!background)
+	{
+		Gahood::criticalSdlError("Failed to create the background texture");
+	}
+
+	if (SDL_RenderClear(renderer) < 0)
+	{
+		Gahood::criticalSdlError("Failed to clear the window");
+	}
+	SDL_RenderPresent(renderer);
+}
+
+void Display::destroyWindow()
+{
+	SDL_DestroyTexture(background);
+	SDL_DestroyRenderer(renderer);
+	SDL_DestroyWindow(window);
+}
+
+void Display::pollEvents()
+{
+	SDL_Event currentEvent;
+	while (SDL_PollEvent(&currentEvent))
+	{
+		if (currentEvent.type == SDL_QUIT)
+		{
+			input.requestQuit();
+		}
+		else if (currentEvent.type == SDL_WINDOWEVENT)
+		{
+			handleWindowEvent(currentEvent.window.event);
+		}
+		else if (currentEvent.type == SDL_KEYUP && currentEvent.key.keysym.scancode == SDL_SCANCODE_V) // Toggle verbose logging
+		{
+			input.requestVerboseToggle();
+		}
+	}
+
+	const unsigned char *keys = SDL_GetKeyboardState(NULL);
+	byte buttons = 0x00;
+	if (keys[SDL_SCANCODE_A]) buttons |= Input::BUTTON_A;
+	if (keys[SDL_SCANCODE_B]) buttons |= Input::BUTTON_B;
+	if (keys[SDL_SCANCODE_LSHIFT]) buttons |= Input::BUTTON_SELECT;
+	if (keys[SDL_SCANCODE_RETURN]) buttons |= Input::BUTTON_START;
+	if (keys[SDL_SCANCODE_RIGHT]) buttons |= Input::BUTTON_RIGHT;
+	if (keys[SDL_SCANCODE_LEFT]) buttons |= Input::BUTTON_LEFT;
+	if (keys[SDL_SCANCODE_UP]) buttons |= Input::BUTTON_UP;
+	if (keys[SDL_SCANCODE_DOWN]) buttons |= Input::BUTTON_DOWN;
+	input.setButtons(buttons);
+}
+
+void Display::handleWindowEvent(const Uint8 windowEvent)
+{
+	switch (windowEvent)
+	{
+	case SDL_WINDOWEVENT_EXPOSED:
+		showingFrame = false; // The window contents are gone, the next frame has to be drawn even if unchanged
+		SDL_AtomicSet(&windowVisible, 1);
+		break;
+	case SDL_WINDOWEVENT_SHOWN:
+	case SDL_WINDOWEVENT_RESTORED:
+	case SDL_WINDOWEVENT_MAXIMIZED:
+		SDL_AtomicSet(&windowVisible, 1);
+		break;
+	case SDL_WINDOWEVENT_HIDDEN:
+	case SDL_WINDOWEVENT_MINIMIZED:
+		SDL_AtomicSet(&windowVisible, 0);
+		break;
+	default:
+		break;
+	}
+}
+
+void Display::present(const Frame *frame)
+{
+	// Menus and dialogue repeat the same image for many frames, those skip scaling, upload and present
+	const Uint64 frameHash = frame->hash();
+	if (showingFrame && frameHash == shownHash)
+	{
+		SDL_AtomicAdd(&unchangedFrames, 1);
+		return;
+	}
+	shownHash = frameHash;
+	showingFrame = true;
+	SDL_AtomicAdd(&presentedFrames, 1);
+
+	frame->toRgba(rgbaFrame);
+	const Uint32 *pixels = scaler.scale(rgbaFrame);
+	if (SDL_UpdateTexture(background, NULL, pixels, static_cast<int> (scaler.getWidth() * sizeof(Uint32))) < 0)
+	{
+		Gahood::criticalSdlError("Failed to upload the frame to the background texture");
+	}
+	if (SDL_RenderClear(renderer) < 0)
+	{
+		Gahood::criticalSdlError("Failed to clear the window");
+	}
+	if (SDL_RenderCopy(renderer, background, NULL, NULL) < 0)
+	{
+		Gahood::criticalSdlError("Failed to draw the texture to the window");
+	}
+	SDL_RenderPresent(renderer);
+}
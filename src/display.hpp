@@ -0,0 +1,64 @@
+#ifndef _GAHOOD_BOY_DISPLAY_HPP_
+#define _GAHOOD_BOY_DISPLAY_HPP_
+
+#include "screen.hpp"
+#include "triple_buffer.hpp"
+#include "input.hpp"
+#include "scaler.hpp"
+
+/*
+* Owns the SDL window, renderer and event pump on a dedicated presenter thread.
+* The thread that renders frames (the emulation thread, or the render thread with -t) draws
+* into getBackFrame() and hands frames over with publishFrame(), so a slow compositor or a
+* vsync wait never stalls emulation. Frames are upscaled by the
+* Scaler on the presenter thread and the window is sized to the scaled frame.
+* Builds without GAHOOD_BOY_THREADED_PRESENTER (macOS, where windows and events belong to
+* the main thread) do the presenter work from pumpEvents() on the main thread instead.
+*/
+class Display : public Screen
+{
+public:
+	Display(Input &input, const ScaleFilter filter, const byte scaleFactor);
+	~Display();
+
+	Frame * getBackFrame();
+	void publishFrame();
+	bool isVisible();
+	void pumpEvents();
+
+	// Stats, frames actually shown and frames dropped for being identical to the one on screen
+	int getPresentedFrameCount();
+	int getUnchangedFrameCount();
+
+private:
+	Input &input;
+	TripleBuffer frames;
+	SDL_Thread *presenterThread; // NULL when the main thread presents through pumpEvents()
+	SDL_atomic_t running;
+	SDL_atomic_t presentedFrames;
+	SDL_atomic_t unchangedFrames;
+	SDL_atomic_t windowVisible; // Cleared while the window is hidden or minimized
+
+	// Only touched by the thread that presents
+	Scaler scaler;
+	Uint32 *rgbaFrame;
+	SDL_Window *window;
+	SDL_Renderer *renderer;
+	SDL_Texture *background;
+	Uint64 shownHash;
+	bool showingFrame; // False until the first present and after the window needs a redraw
+
+	Display(const Display &other);
+	Display& operator=(const Display &other);
+
+	static int runPresenter(void *display);
+	void presentLoop();
+	bool presentPending(); // Polls events and presents the newest frame, if any arrived
+	void createWindow();
+	void destroyWindow();
+	void pollEvents();
+	void handleWindowEvent(const Uint8 windowEvent);
+	void present(const Frame *frame);
+};
+
+#endif
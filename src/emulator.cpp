@@ -3,20 +3,39 @@
 #include "cpu.hpp"
 #include "video.hpp"
 #include "io.hpp"
+#include "display.hpp"
+#include "headless_screen.hpp"
+#include "recorder.hpp"
+#include "timer.hpp"
+#include <cstring>
 
-static void init();
+static void init(const bool headless);
 static void quit();
+static bool endsWith(const char *text, const char *suffix);
 
 int Emulator::run(int argc, char **argv)
 {
-    init();
-
     if(argc < 2)
     {
         Gahood::criticalError("Invalid arguments passed, must at least pass the path to the rom file.");
     }
 
     char *romPath = argv[1];
+    bool romGuard = false;
+    address watchpoints[16];
+    int watchpointCount = 0;
+    byte maxFrameSkip = 0;
+    bool threadedRendering = false;
+    bool headless = false;
+    size frameLimit = 0;
+    size dumpInterval = 0;
+    const char *dumpPrefix = NULL;
+    FrameDumpFormat dumpFormat = FRAME_DUMP_PPM;
+    ScaleFilter scaleFilter = SCALE_NEAREST;
+    byte scaleFactor = 3;
+    const char *recordPath = NULL;
+    bool recordDirectIo = false;
+    bool recordDropFrames = false;
     for(int i = 2; i < argc; i++)
     {
         if(Gahood::stringLiteralEquals(argv[i], "-d"))
@@ -29,26 +48,146 @@ int Emulator::run(int argc, char **argv)
             Gahood::log("Very verbose mode enabled.");
             Gahood::setVerboseMode(true);
         }
+        else if(Gahood::stringLiteralEquals(argv[i], "-g"))
+        {
+            Gahood::log("Guard page mode enabled.");
+            romGuard = true;
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-s") && i + 1 < argc)
+        {
+            i++;
+            const long skip = strtol(argv[i], NULL, 10);
+            maxFrameSkip = static_cast<byte> (skip < 0 ? 0 : (skip > 0xFF ? 0xFF : skip));
+            Gahood::log("Adaptive frameskip enabled, skipping at most %d frames in a row.", maxFrameSkip);
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-t"))
+        {
+            Gahood::log("Rendering scanlines on a worker thread.");
+            threadedRendering = true;
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-headless"))
+        {
+            Gahood::log("Headless mode enabled.");
+            headless = true;
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-frames") && i + 1 < argc)
+        {
+            i++;
+            frameLimit = strtoul(argv[i], NULL, 10);
+        }
+        else if((Gahood::stringLiteralEquals(argv[i], "-dump") || Gahood::stringLiteralEquals(argv[i], "-dumpraw")) && i + 2 < argc)
+        {
+            dumpFormat = Gahood::stringLiteralEquals(argv[i], "-dump") ? FRAME_DUMP_PPM : FRAME_DUMP_RAW;
+            dumpInterval = strtoul(argv[i + 1], NULL, 10);
+            dumpPrefix = argv[i + 2];
+            i += 2;
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-scale") && i + 1 < argc)
+        {
+            i++;
+            const long factor = strtol(argv[i], NULL, 10);
+            scaleFactor = static_cast<byte> (factor < 1 ? 1 : (factor > Scaler::MAX_FACTOR ? Scaler::MAX_FACTOR : factor));
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-filter") && i + 1 < argc)
+        {
+            i++;
+            if(Gahood::stringLiteralEquals(argv[i], "scale2x"))
+            {
+                scaleFilter = SCALE_2X;
+            }
+            else if(Gahood::stringLiteralEquals(argv[i], "scale3x"))
+            {
+                scaleFilter = SCALE_3X;
+            }
+            else
+            {
+                scaleFilter = SCALE_NEAREST;
+            }
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-record") && i + 1 < argc)
+        {
+            i++;
+            recordPath = argv[i];
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-direct"))
+        {
+            recordDirectIo = true;
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-recorddrop"))
+        {
+            recordDropFrames = true;
+        }
+        else if(Gahood::stringLiteralEquals(argv[i], "-w") && i + 1 < argc && watchpointCount < 16)
+        {
+            i++;
+            watchpoints[watchpointCount] = static_cast<address> (strtol(argv[i], NULL, 16));
+            watchpointCount++;
+        }
         else
         {
             Gahood::log("Ignoring passed argument %s.", argv[i]);
         }
     }
 
+    if(!headless && (frameLimit > 0 || dumpInterval > 0))
+    {
+        Gahood::log("-frames and -dump only apply with -headless, ignoring them.");
+    }
+    if(recordPath && maxFrameSkip > 0)
+    {
+        // Skipped frames would leave holes in the recording
+        Gahood::log("Frameskip is disabled while recording.");
+        maxFrameSkip = 0;
+    }
+
+    init(headless);
+
     Gahood::log("Loading ROM %s", romPath);
 
 	Cartridge cartridge(romPath);
-	Memory memory(cartridge);
+	Memory memory(cartridge, romGuard);
+	for(int i = 0; i < watchpointCount; i++)
+	{
+		memory.addWatchpoint(watchpoints[i]);
+	}
 
-	Cpu cpu;
-	Video video(memory);
-	IO io;
+	Input input;
+	{
+		// Scoped so the presenter thread is joined before quit() shuts SDL down
+		Screen *screen = headless ?
+			static_cast<Screen *> (new HeadlessScreen(input, frameLimit, dumpInterval, dumpPrefix, dumpFormat)) :
+			static_cast<Screen *> (new Display(input, scaleFilter, scaleFactor));
+		Screen *output = screen;
+		if(recordPath)
+		{
+			const RecordFormat recordFormat = endsWith(recordPath, ".y4m") ? RECORD_Y4M : RECORD_RAW;
+			Gahood::log("Recording frames to %s", recordPath);
+			output = new RecordingScreen(*screen, recordPath, recordFormat, recordDirectIo, recordDropFrames);
+		}
+		{
+			// Scoped so the render thread has replayed its last frames before the screens go away
+			Cpu cpu(memory.isCgbMode());
+			Video video(memory, *output, maxFrameSkip, threadedRendering);
+			IO io(input);
+			Timer eventTimer(1);
 
-	cycle clocksSpent;
-    while((clocksSpent = cpu.update(memory) >= 0) && io.update(memory))
-    {
-		video.render(memory, clocksSpent);
-    }
+			cycle clocksSpent;
+			while((clocksSpent = cpu.update(memory)) >= 0 && io.update(memory))
+			{
+				memory.handleTrappedWrites();
+				video.render(memory, clocksSpent);
+				if(eventTimer.checkAndReset())
+				{
+					output->pumpEvents();
+				}
+			}
+		}
+		if(output != screen)
+		{
+			delete output;
+		}
+		delete screen;
+	}
 
     if(Gahood::isDebugMode())
     {
@@ -62,9 +201,11 @@ int Emulator::run(int argc, char **argv)
 	return 0;
 }
 
-static void init()
+static void init(const bool headless)
 {
-    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
+    // Headless runs only need the timers, so they work on machines without any display
+    const Uint32 subsystems = headless ? SDL_INIT_TIMER : SDL_INIT_VIDEO | SDL_INIT_AUDIO;
+    if(SDL_Init(subsystems) < 0)
     {
         Gahood::criticalSdlError("Failed to initialize SDL2");
     }
@@ -73,4 +214,11 @@ static void init()
 static void quit()
 {
     SDL_Quit();
+}
+
+static bool endsWith(const char *text, const char *suffix)
+{
+    const size textLength = strlen(text);
+    const size suffixLength = strlen(suffix);
+    return textLength >= suffixLength && strcmp(text + textLength - suffixLength, suffix) == 0;
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "frame.hpp"
+#include "simd.hpp"
+#include <cstring>
+
+typedef void (*ToRgbaKernel)(const byte *pixels, const Uint32 *colors, Uint32 *rgba, const size pixelCount);
+
+static void selectToRgba(const byte *pixels, const Uint32 *colors, Uint32 *rgba, const size pixelCount);
+
+static ToRgbaKernel toRgbaKernel = selectToRgba;
+
+static const Uint64 HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+static inline Uint64 mix(const Uint64 hash, const Uint64 word)
+{
+	const Uint64 mixed = (hash ^ word) * HASH_MULTIPLIER;
+	return mixed ^ (mixed >> 29);
+}
+
+Uint64 Frame::hash() const
+{
+	// Four independent lanes so the multiplies overlap instead of forming one long chain
+	Uint64 lanes[4] = { 1, 2, 3, 4 };
+	const byte *bytes = pixels;
+	const size wordCount = sizeof(Frame::pixels) / 8;
+	for (size word = 0; word + 4 <= wordCount; word += 4)
+	{
+		Uint64 words[4];
+		memcpy(words, bytes + word * sizeof(Uint64), sizeof(words));
+		lanes[0] = mix(lanes[0], words[0]);
+		lanes[1] = mix(lanes[1], words[1]);
+		lanes[2] = mix(lanes[2], words[2]);
+		lanes[3] = mix(lanes[3], words[3]);
+	}
+	for (byte color = 0; color < 64; color++)
+	{
+		lanes[color & 0x03] = mix(lanes[color & 0x03], colors[color]);
+	}
+	return mix(mix(mix(lanes[0], lanes[1]), lanes[2]), lanes[3]);
+}
+
+void Frame::toRgba(Uint32 *rgba) const
+{
+	toRgbaKernel(pixels, colors, rgba, 160 * 144);
+}
+
+void Frame::resetKernels()
+{
+	toRgbaKernel = selectToRgba;
+}
+
+static void toRgbaScalar(const byte *pixels, const Uint32 *colors, Uint32 *rgba, const size pixelCount)
+{
+	for (size pixel = 0; pixel < pixelCount; pixel++)
+	{
+		rgba[pixel] = colors[pixels[pixel] & 0x3F];
+	}
+}
+
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+
+// 8 pixels per gather, the mask keeps stray values inside the 64 entry table like the scalar path
+GAHOOD_BOY_TARGET("avx2")
+static void toRgbaAvx2(const byte *pixels, const Uint32 *colors, Uint32 *rgba, const size pixelCount)
+{
+	const __m256i indexMask = _mm256_set1_epi32(0x3F);
+	size pixel = 0;
+	for (; pixel + 8 <= pixelCount; pixel += 8)
+	{
+		const __m256i indices = _mm256_and_si256(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *> (pixels + pixel))), indexMask);
+		const __m256i converted = _mm256_i32gather_epi32(reinterpret_cast<const int *> (colors), indices, 4);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *> (rgba + pixel), converted);
+	}
+	toRgbaScalar(pixels + pixel, colors, rgba + pixel, pixelCount - pixel);
+}
+
+#endif
+
+static void selectToRgba(const byte *pixels, const Uint32 *colors, Uint32 *rgba, const size pixelCount)
+{
+	toRgbaKernel = toRgbaScalar;
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+	if (Simd::hasAvx2())
+	{
+		toRgbaKernel = toRgbaAvx2;
+	}
+#endif
+	toRgbaKernel(pixels, colors, rgba, pixelCount);
+}
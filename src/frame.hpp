@@ -0,0 +1,24 @@
+#ifndef _GAHOOD_BOY_FRAME_HPP_
+#define _GAHOOD_BOY_FRAME_HPP_
+
+#include "util.hpp"
+
+/*
+* One finished 160x144 LCD image. Every pixel is one byte, the 2-bit color in the low
+* bits and the pallette id above them, and colors maps each of those values to RGBA8888.
+* Host colors only come into play when a frame is shown or written out.
+*/
+struct Frame
+{
+	byte pixels[160 * 144];
+	Uint32 colors[64];
+
+	// 64 bit content hash, equal frames always hash the same
+	Uint64 hash() const;
+	void toRgba(Uint32 *rgba) const;
+
+	// The next toRgba chooses its kernel again, for the tests after a Simd::limitLevel
+	static void resetKernels();
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "frame_skip.hpp"
+
+FrameSkip::FrameSkip(const byte maxSkip)
+{
+	this->maxSkip = maxSkip;
+	skippedInRow = 0;
+	drawing = true;
+	emulatedFrames = 0;
+	hostStart = Gahood::getCurrentMicroseconds();
+	frameCost = 0;
+	averageCost = 0;
+}
+
+bool FrameSkip::isEnabled() const
+{
+	return maxSkip > 0;
+}
+
+bool FrameSkip::beginFrame()
+{
+	if (drawing)
+	{
+		// Moving average over roughly the last 8 drawn frames
+		averageCost = averageCost - averageCost / 8 + frameCost / 8;
+	}
+	frameCost = 0;
+	if (maxSkip == 0)
+	{
+		return true;
+	}
+
+	emulatedFrames++;
+	const microseconds now = Gahood::getCurrentMicroseconds();
+	const microseconds frameTime = static_cast<microseconds> (GAMEBOY_CLOCKS_PER_FRAME) * 1000000 / GAMEBOY_CLOCK_SPEED;
+	const microseconds emulatedEnd = hostStart + getEmulatedTime();
+	// Keep at most a frame of lead or lag, so a fast stretch can't hide the next slow one
+	// and skipping stops as soon as the host keeps up again instead of paying back old debt
+	if (now + frameTime < emulatedEnd)
+	{
+		hostStart -= emulatedEnd - (now + frameTime);
+	}
+	else if (now > emulatedEnd + frameTime)
+	{
+		hostStart += now - (emulatedEnd + frameTime);
+	}
+
+	const bool fallsBehind = now + averageCost > hostStart + getEmulatedTime();
+	drawing = !fallsBehind || skippedInRow >= maxSkip;
+	skippedInRow = drawing ? 0 : skippedInRow + 1;
+	return drawing;
+}
+
+void FrameSkip::addRenderCost(const microseconds cost)
+{
+	frameCost += cost;
+}
+
+microseconds FrameSkip::getEmulatedTime() const
+{
+	return static_cast<microseconds> (emulatedFrames) * GAMEBOY_CLOCKS_PER_FRAME * 1000000 / GAMEBOY_CLOCK_SPEED;
+}
@@ -0,0 +1,33 @@
+#ifndef _GAHOOD_BOY_FRAME_SKIP_HPP_
+#define _GAHOOD_BOY_FRAME_SKIP_HPP_
+
+#include "util.hpp"
+
+/*
+* Decides per emulated frame whether its pixels are worth generating.
+* Emulated time (70224 clocks a frame) is compared against host time, and a frame is
+* skipped when drawing it at the measured render cost would leave emulation behind.
+* At most maxSkip frames in a row are skipped, a maxSkip of 0 always draws.
+*/
+class FrameSkip
+{
+public:
+	FrameSkip(const byte maxSkip);
+
+	bool isEnabled() const;
+	bool beginFrame();
+	void addRenderCost(const microseconds cost);
+
+private:
+	byte maxSkip;
+	byte skippedInRow;
+	bool drawing;
+	size emulatedFrames;
+	microseconds hostStart;
+	microseconds frameCost; // Render and present time spent on the current frame
+	microseconds averageCost;
+
+	microseconds getEmulatedTime() const;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "headless_screen.hpp"
+#include <stdio.h>
+#include <cstring>
+
+static const char PPM_HEADER[] = "P6\n160 144\n255\n";
+static const size PPM_HEADER_SIZE = sizeof(PPM_HEADER) - 1;
+static const size RGB_FRAME_SIZE = 160 * 144 * 3;
+
+HeadlessScreen::HeadlessScreen(Input &input, const size frameLimit, const size dumpInterval,
+	const char *dumpPrefix, const FrameDumpFormat dumpFormat) : input(input)
+{
+	frame = (Frame *) calloc(1, sizeof(Frame));
+	dumpBytes = (byte *) malloc(PPM_HEADER_SIZE + RGB_FRAME_SIZE);
+	if (!frame || !dumpBytes)
+	{
+		Gahood::criticalError("Failed to allocate the headless frame");
+	}
+	memcpy(dumpBytes, PPM_HEADER, PPM_HEADER_SIZE);
+
+	frameCount = 0;
+	this->frameLimit = frameLimit;
+	this->dumpInterval = dumpInterval;
+	this->dumpPrefix = dumpPrefix;
+	this->dumpFormat = dumpFormat;
+}
+
+HeadlessScreen::~HeadlessScreen()
+{
+	free(dumpBytes);
+	free(frame);
+}
+
+Frame * HeadlessScreen::getBackFrame()
+{
+	// Frames are consumed on the thread that renders them, so one buffer is enough
+	return frame;
+}
+
+void HeadlessScreen::publishFrame()
+{
+	if (frameLimit > 0 && frameCount >= frameLimit)
+	{
+		return; // A render thread can still be finishing frames logged before the quit was seen
+	}
+	frameCount++;
+	if (dumpInterval > 0 && frameCount % dumpInterval == 0)
+	{
+		dumpFrame();
+	}
+	if (frameLimit > 0 && frameCount == frameLimit)
+	{
+		input.requestQuit();
+	}
+}
+
+const Frame * HeadlessScreen::getLatestFrame() const
+{
+	return frame;
+}
+
+size HeadlessScreen::getFrameCount() const
+{
+	return frameCount;
+}
+
+void HeadlessScreen::dumpFrame()
+{
+	byte *rgb = dumpBytes + PPM_HEADER_SIZE;
+	for (size pixel = 0; pixel < 160 * 144; pixel++)
+	{
+		const Uint32 color = frame->colors[frame->pixels[pixel] & 0x3F]; // RGBA8888, red in the most significant byte
+		rgb[pixel * 3] = static_cast<byte> (color >> 24);
+		rgb[pixel * 3 + 1] = static_cast<byte> (color >> 16);
+		rgb[pixel * 3 + 2] = static_cast<byte> (color >> 8);
+	}
+
+	char filePath[4096];
+	const bool isPpm = dumpFormat == FRAME_DUMP_PPM;
+	snprintf(filePath, sizeof(filePath), "%s%06lu.%s", dumpPrefix, frameCount, isPpm ? "ppm" : "rgb");
+	if (isPpm)
+	{
+		Gahood::writeToFile(filePath, dumpBytes, PPM_HEADER_SIZE + RGB_FRAME_SIZE);
+	}
+	else
+	{
+		Gahood::writeToFile(filePath, rgb, RGB_FRAME_SIZE);
+	}
+}
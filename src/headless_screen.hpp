@@ -0,0 +1,47 @@
+#ifndef _GAHOOD_BOY_HEADLESS_SCREEN_HPP_
+#define _GAHOOD_BOY_HEADLESS_SCREEN_HPP_
+
+#include "screen.hpp"
+#include "input.hpp"
+
+enum FrameDumpFormat
+{
+	FRAME_DUMP_PPM,
+	FRAME_DUMP_RAW // Bare 160x144 RGB24, the PPM body without its header
+};
+
+/*
+* Screen for batch and CI runs that never touches SDL video.
+* The newest frame is kept for callers to inspect, every dumpInterval-th frame can be
+* written to <dumpPrefix><frame number>.ppm/.rgb, and a quit is requested once
+* frameLimit frames were published. An interval or limit of 0 turns that part off.
+*/
+class HeadlessScreen : public Screen
+{
+public:
+	HeadlessScreen(Input &input, const size frameLimit, const size dumpInterval, const char *dumpPrefix, const FrameDumpFormat dumpFormat);
+	~HeadlessScreen();
+
+	Frame * getBackFrame();
+	void publishFrame();
+
+	const Frame * getLatestFrame() const;
+	size getFrameCount() const;
+
+private:
+	Input &input;
+	Frame *frame;
+	size frameCount;
+	size frameLimit;
+	size dumpInterval;
+	const char *dumpPrefix;
+	FrameDumpFormat dumpFormat;
+	byte *dumpBytes;
+
+	HeadlessScreen(const HeadlessScreen &other);
+	HeadlessScreen& operator=(const HeadlessScreen &other);
+
+	void dumpFrame();
+};
+
+#endif
@@ -0,0 +1,40 @@
+#include "input.hpp"
+
+Input::Input()
+{
+	SDL_AtomicSet(&buttons, 0);
+	SDL_AtomicSet(&quitRequested, 0);
+	SDL_AtomicSet(&verboseToggles, 0);
+}
+
+byte Input::getButtons()
+{
+	return static_cast<byte> (SDL_AtomicGet(&buttons));
+}
+
+void Input::setButtons(const byte buttons)
+{
+	SDL_AtomicSet(&this->buttons, buttons);
+}
+
+bool Input::isQuitRequested()
+{
+	return SDL_AtomicGet(&quitRequested) != 0;
+}
+
+void Input::requestQuit()
+{
+	SDL_AtomicSet(&quitRequested, 1);
+}
+
+bool Input::takeVerboseToggle()
+{
+	// Presses are counted, an even number of them between two polls cancels out
+	const int toggles = SDL_AtomicSet(&verboseToggles, 0);
+	return (toggles & 0x01) == 0x01;
+}
+
+void Input::requestVerboseToggle()
+{
+	SDL_AtomicAdd(&verboseToggles, 1);
+}
@@ -0,0 +1,41 @@
+#ifndef _GAHOOD_BOY_INPUT_HPP_
+#define _GAHOOD_BOY_INPUT_HPP_
+
+#include "util.hpp"
+
+/*
+* Input gathered by the presenter thread for the emulation thread.
+* Buttons use the joypad bit order, action buttons in the low nibble and directions
+* in the high nibble, with a set bit meaning pressed.
+*/
+class Input
+{
+public:
+	enum Button
+	{
+		BUTTON_A = 0x01,
+		BUTTON_B = 0x02,
+		BUTTON_SELECT = 0x04,
+		BUTTON_START = 0x08,
+		BUTTON_RIGHT = 0x10,
+		BUTTON_LEFT = 0x20,
+		BUTTON_UP = 0x40,
+		BUTTON_DOWN = 0x80
+	};
+
+	Input();
+
+	byte getButtons();
+	void setButtons(const byte buttons);
+	bool isQuitRequested();
+	void requestQuit();
+	bool takeVerboseToggle();
+	void requestVerboseToggle();
+
+private:
+	SDL_atomic_t buttons;
+	SDL_atomic_t quitRequested;
+	SDL_atomic_t verboseToggles;
+};
+
+#endif
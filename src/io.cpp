@@ -1,6 +1,6 @@
 #include "io.hpp"
 
-IO::IO()
+IO::IO(Input &input) : input(input)
 {
 	updateTimer = Timer(2); // TODO innacurate
 }
@@ -8,34 +8,27 @@ IO::IO()
 bool IO::update(Memory &memory)
 {
 	updateTimers(memory);
-	while (SDL_PollEvent(&currentEvent))
+	if (input.isQuitRequested())
 	{
-		if (currentEvent.type == SDL_QUIT)
-		{
-			return false;
-		}
-		else if(currentEvent.type == SDL_KEYUP && currentEvent.key.keysym.scancode == SDL_SCANCODE_V) // Toggle verbose logging
-		{
-			Gahood::setVerboseMode(!Gahood::isVerboseMode());
-		}
+		return false;
 	}
-	const unsigned char *keys = SDL_GetKeyboardState(NULL);
+	if (input.takeVerboseToggle())
+	{
+		Gahood::setVerboseMode(!Gahood::isVerboseMode());
+	}
+
+	// Joypad lines read 0 while pressed, only the selected group is reported
+	const byte pressed = input.getButtons();
 	const byte joypad = memory.read(0xFF00);
 	const bool isButtonKeys = (joypad & 0x20) == 0x00;
 	const bool isDirectionKeys = (joypad & 0x10) == 0x00;
 	if(isButtonKeys)
 	{
-		if(keys[SDL_SCANCODE_A]) memory.write(0xFF00, joypad & 0xFE); else memory.write(0xFF00, joypad | 0x01);
-		if(keys[SDL_SCANCODE_B]) memory.write(0xFF00, joypad & 0xFD); else memory.write(0xFF00, joypad | 0x02);
-		if(keys[SDL_SCANCODE_LSHIFT]) memory.write(0xFF00, joypad & 0xFB); else memory.write(0xFF00, joypad | 0x04);
-		if(keys[SDL_SCANCODE_RETURN]) memory.write(0xFF00, joypad & 0xF7); else memory.write(0xFF00, joypad | 0x08);
+		memory.write(0xFF00, (joypad & 0xF0) | (~pressed & 0x0F));
 	}
 	else if(isDirectionKeys)
 	{
-		if(keys[SDL_SCANCODE_RIGHT]) memory.write(0xFF00, joypad & 0xFE); else memory.write(0xFF00, joypad | 0x01);
-		if(keys[SDL_SCANCODE_LEFT]) memory.write(0xFF00, joypad & 0xFD); else memory.write(0xFF00, joypad | 0x02);
-		if(keys[SDL_SCANCODE_UP]) memory.write(0xFF00, joypad & 0xFB); else memory.write(0xFF00, joypad | 0x04);
-		if(keys[SDL_SCANCODE_DOWN]) memory.write(0xFF00, joypad & 0xF7); else memory.write(0xFF00, joypad | 0x08);
+		memory.write(0xFF00, (joypad & 0xF0) | (~pressed >> 4 & 0x0F));
 	}
 	return true;
 }
@@ -2,16 +2,17 @@
 #define _GAHOOD_BOY_IO_HPP_
 
 #include "memory.hpp"
+#include "input.hpp"
 #include "timer.hpp"
 
 class IO
 {
 public:
-	IO();
+	IO(Input &input);
 	bool update(Memory &memory);
 
 private:
-	SDL_Event currentEvent;
+	Input &input;
 	Timer updateTimer;
 
 	void updateTimers(Memory &memory);
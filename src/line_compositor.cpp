@@ -0,0 +1,107 @@
+#include "line_compositor.hpp"
+#include "simd.hpp"
+
+typedef void (*ComposeKernel)(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width);
+
+static void selectCompose(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width);
+
+static ComposeKernel composeKernel = selectCompose;
+
+void LineCompositor::compose(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width)
+{
+    composeKernel(linePixels, bgIndices, spriteLine, width);
+}
+
+void LineCompositor::resetKernels()
+{
+    composeKernel = selectCompose;
+}
+
+static void composeScalar(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width)
+{
+    for(size x = 0; x < width; x++)
+    {
+        const byte sprite = spriteLine[x];
+        const bool opaque = (sprite & LineCompositor::SPRITE_OPAQUE) != 0;
+        const bool hidden = (sprite & LineCompositor::SPRITE_BEHIND_BG) != 0 && bgIndices[x] != 0x00;
+        if(opaque && !hidden)
+        {
+            linePixels[x] = sprite & LineCompositor::SPRITE_PIXEL_MASK;
+        }
+    }
+}
+
+#ifdef GAHOOD_BOY_SIMD_X86
+
+// 16 pixels per iteration: useSprite = opaque & !(behind & bgIndex != 0)
+GAHOOD_BOY_TARGET("sse2")
+static void composeSse2(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width)
+{
+    const __m128i opaqueBit = _mm_set1_epi8(LineCompositor::SPRITE_OPAQUE);
+    const __m128i behindBit = _mm_set1_epi8(static_cast<char> (LineCompositor::SPRITE_BEHIND_BG));
+    const __m128i pixelMask = _mm_set1_epi8(LineCompositor::SPRITE_PIXEL_MASK);
+    const __m128i zero = _mm_setzero_si128();
+    size x = 0;
+    for(; x + 16 <= width; x += 16)
+    {
+        const __m128i sprite = _mm_loadu_si128(reinterpret_cast<const __m128i *> (spriteLine + x));
+        const __m128i bgIndex = _mm_loadu_si128(reinterpret_cast<const __m128i *> (bgIndices + x));
+        const __m128i background = _mm_loadu_si128(reinterpret_cast<const __m128i *> (linePixels + x));
+
+        const __m128i opaque = _mm_cmpeq_epi8(_mm_and_si128(sprite, opaqueBit), opaqueBit);
+        const __m128i behind = _mm_cmpeq_epi8(_mm_and_si128(sprite, behindBit), behindBit);
+        const __m128i hidden = _mm_andnot_si128(_mm_cmpeq_epi8(bgIndex, zero), behind);
+        const __m128i useSprite = _mm_andnot_si128(hidden, opaque);
+        const __m128i composed = _mm_or_si128(_mm_and_si128(useSprite, _mm_and_si128(sprite, pixelMask)), _mm_andnot_si128(useSprite, background));
+        _mm_storeu_si128(reinterpret_cast<__m128i *> (linePixels + x), composed);
+    }
+    composeScalar(linePixels + x, bgIndices + x, spriteLine + x, width - x);
+}
+
+#endif
+
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+
+GAHOOD_BOY_TARGET("avx2")
+static void composeAvx2(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width)
+{
+    const __m256i opaqueBit = _mm256_set1_epi8(LineCompositor::SPRITE_OPAQUE);
+    const __m256i behindBit = _mm256_set1_epi8(static_cast<char> (LineCompositor::SPRITE_BEHIND_BG));
+    const __m256i pixelMask = _mm256_set1_epi8(LineCompositor::SPRITE_PIXEL_MASK);
+    const __m256i zero = _mm256_setzero_si256();
+    size x = 0;
+    for(; x + 32 <= width; x += 32)
+    {
+        const __m256i sprite = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (spriteLine + x));
+        const __m256i bgIndex = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (bgIndices + x));
+        const __m256i background = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (linePixels + x));
+
+        const __m256i opaque = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, opaqueBit), opaqueBit);
+        const __m256i behind = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, behindBit), behindBit);
+        const __m256i hidden = _mm256_andnot_si256(_mm256_cmpeq_epi8(bgIndex, zero), behind);
+        const __m256i useSprite = _mm256_andnot_si256(hidden, opaque);
+        const __m256i composed = _mm256_blendv_epi8(background, _mm256_and_si256(sprite, pixelMask), useSprite);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *> (linePixels + x), composed);
+    }
+    composeScalar(linePixels + x, bgIndices + x, spriteLine + x, width - x);
+}
+
+#endif
+
+static void selectCompose(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width)
+{
+    composeKernel = composeScalar;
+#ifdef GAHOOD_BOY_SIMD_X86
+    if(Simd::hasSse2())
+    {
+        composeKernel = composeSse2;
+    }
+#endif
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+    if(Simd::hasAvx2())
+    {
+        composeKernel = composeAvx2;
+    }
+#endif
+    composeKernel(linePixels, bgIndices, spriteLine, width);
+}
@@ -0,0 +1,24 @@
+#ifndef _GAHOOD_BOY_LINE_COMPOSITOR_HPP_
+#define _GAHOOD_BOY_LINE_COMPOSITOR_HPP_
+
+#include "util.hpp"
+
+/*
+* Merges a rendered sprite line over the background/window line without per pixel
+* branches. Sprite line bytes are 0 where no sprite pixel is opaque, otherwise the
+* frame pixel value with SPRITE_OPAQUE and, for OBJ-to-BG priority, SPRITE_BEHIND_BG set.
+* A sprite pixel wins unless it is behind the background and the background color
+* index there is not 0. The kernel (scalar, SSE2 or AVX2) is chosen on first use.
+*/
+namespace LineCompositor
+{
+    const byte SPRITE_OPAQUE = 0x40;
+    const byte SPRITE_BEHIND_BG = 0x80;
+    const byte SPRITE_PIXEL_MASK = 0x3F;
+
+    void compose(byte *linePixels, const byte *bgIndices, const byte *spriteLine, const size width);
+    // The next call chooses its kernel again, for the tests after a Simd::limitLevel
+    void resetKernels();
+}
+
+#endif
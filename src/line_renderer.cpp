@@ -0,0 +1,473 @@
+#include "line_renderer.hpp"
+#include "line_compositor.hpp"
+#include <cstring>
+
+// Pallette ids of the DMG pallette registers in frame pixel values
+static const byte BG_PALLETTE_ID = 0;
+static const byte OBJ_PALLETTE_0_ID = 1;
+static const byte OBJ_PALLETTE_1_ID = 2;
+
+// Frame pixel value (shade | pallette id << 2) for every pallette id, pallette register value and 2-bit color index
+static byte palletteColors[3][256][4];
+// RGBA8888 for every DMG frame pixel value, the shades are the same whichever register picked them
+static Uint32 dmgColors[64];
+// CGB frame pixel value for every pallette (BG 0-7, OBJ 8-15) and 2-bit color index
+static byte cgbPalletteColors[16][4];
+// RGBA8888 for every RGB555 pallette RAM color
+static Uint32 rgb555Colors[0x8000];
+
+// Set in CGB background color indices of tiles that hide sprites behind colors 1-3
+static const byte BG_OVER_OBJ = 0x04;
+// Background color index as seen by the compositor, without and with BG_OVER_OBJ for the tile
+static const byte cgbBgIndices[2][4] = { { 0, 1, 2, 3 }, { 0, 1 | BG_OVER_OBJ, 2 | BG_OVER_OBJ, 3 | BG_OVER_OBJ } };
+
+static void buildPalletteColors();
+
+LineRenderer::LineRenderer(const Memory &memory)
+{
+	framebuffer = (byte *) calloc(160 * 144, sizeof(byte));
+	vram = (byte *) calloc(2 * 0x2000, sizeof(byte));
+	if (!framebuffer || !vram)
+	{
+		Gahood::criticalError("Failed to allocate the line renderer buffers");
+	}
+
+	buildPalletteColors();
+	bgPallette = 0x00;
+	objPallette0 = 0x00;
+	objPallette1 = 0x00;
+	bgColors = palletteColors[BG_PALLETTE_ID][bgPallette];
+	objColors0 = palletteColors[OBJ_PALLETTE_0_ID][objPallette0];
+	objColors1 = palletteColors[OBJ_PALLETTE_1_ID][objPallette1];
+	for (byte line = 0; line < 144; line++)
+	{
+		lineSpriteCounts[line] = 0;
+	}
+	windowLine = 0;
+	vramBank = 0;
+	cgbMode = memory.isCgbMode();
+	memset(cgbPallettes, 0xFF, sizeof(cgbPallettes)); // White, like Memory after the CGB boot ROM
+	for (byte value = 0; value < 64; value++)
+	{
+		cgbColors[value] = rgb555Colors[0x7FFF];
+	}
+
+	// Start from whatever memory holds, every later change arrives through write().
+	// VRAM bank 1 starts out empty as the renderer is created before the CPU runs.
+	for (address addr = 0x8000; addr < 0xA000; addr++)
+	{
+		vram[addr - 0x8000] = memory.read(addr);
+	}
+	for (address addr = 0xFE00; addr < 0xFEA0; addr++)
+	{
+		oam[addr - 0xFE00] = memory.read(addr);
+	}
+	tileCache.updateRows(0, 0x8000, vram, 0x1800 / 2);
+	cgbPalletteIndices[0] = memory.read(0xFF68);
+	cgbPalletteIndices[1] = memory.read(0xFF6A);
+	for (address addr = 0xFF40; addr <= 0xFF4B; addr++)
+	{
+		writeRegister(addr, memory.read(addr));
+	}
+}
+
+LineRenderer::~LineRenderer()
+{
+	free(vram);
+	free(framebuffer);
+}
+
+void LineRenderer::write(const address addr, const byte byteWritten)
+{
+	if (static_cast<address> (addr - 0x8000) < 0x2000)
+	{
+		byte *bank = vram + vramBank * 0x2000;
+		bank[addr - 0x8000] = byteWritten;
+		if (addr < 0x9800) // Tile data
+		{
+			const address rowAddr = addr & 0xFFFE;
+			tileCache.updateRow(vramBank, rowAddr, bank[rowAddr - 0x8000], bank[rowAddr - 0x8000 + 0x01]);
+		}
+	}
+	else if (static_cast<address> (addr - 0xFE00) < 0xA0)
+	{
+		oam[addr - 0xFE00] = byteWritten;
+	}
+	else
+	{
+		writeRegister(addr, byteWritten);
+	}
+}
+
+void LineRenderer::writeBlock(const address addr, const byte *bytes, const size length)
+{
+	byte *bank = vram + vramBank * 0x2000;
+	memcpy(bank + (addr - 0x8000), bytes, length);
+	if (addr < 0x9800) // Tile data, the run starts on a row so whole rows are decoded at once
+	{
+		const size tileBytes = addr + length > 0x9800 ? 0x9800 - addr : length;
+		tileCache.updateRows(vramBank, addr, bank + (addr - 0x8000), tileBytes / 2);
+	}
+}
+
+void LineRenderer::writeRegister(const address addr, const byte byteWritten)
+{
+	switch (addr)
+	{
+	case 0xFF40: // LCDC, whether the LCD is on at all is up to Video
+		lcdWindowTileMapSelect = Gahood::bitOn(byteWritten, 6);
+		lcdWindowDisplayEnabled = Gahood::bitOn(byteWritten, 5);
+		lcdWindowBgTileSelect = Gahood::bitOn(byteWritten, 4);
+		lcdBgTileMapDisplaySelect = Gahood::bitOn(byteWritten, 3);
+		spriteSizeDetermine = Gahood::bitOn(byteWritten, 2);
+		spriteSizeDisplayEnabled = Gahood::bitOn(byteWritten, 1);
+		bgCgbDisplay = Gahood::bitOn(byteWritten, 0);
+		break;
+	case 0xFF42:
+		scrollY = byteWritten;
+		break;
+	case 0xFF43:
+		scrollX = byteWritten;
+		break;
+	case 0xFF47:
+		updatePallette(byteWritten, BG_PALLETTE_ID, bgPallette, bgColors);
+		break;
+	case 0xFF48:
+		updatePallette(byteWritten, OBJ_PALLETTE_0_ID, objPallette0, objColors0);
+		break;
+	case 0xFF49:
+		updatePallette(byteWritten, OBJ_PALLETTE_1_ID, objPallette1, objColors1);
+		break;
+	case 0xFF4A:
+		windowY = byteWritten;
+		break;
+	case 0xFF4B:
+		windowX = byteWritten;
+		break;
+	case 0xFF4F: // VBK
+		vramBank = byteWritten & 0x01;
+		break;
+	case 0xFF68: // BCPS
+		cgbPalletteIndices[0] = byteWritten;
+		break;
+	case 0xFF69: // BCPD
+		writePalletteData(0, byteWritten);
+		break;
+	case 0xFF6A: // OCPS
+		cgbPalletteIndices[1] = byteWritten;
+		break;
+	case 0xFF6B: // OCPD
+		writePalletteData(1, byteWritten);
+		break;
+	default: // STAT, LY, LYC and DMA only matter to PPU timing
+		break;
+	}
+}
+
+void LineRenderer::updatePallette(const byte pallette, const byte palletteId, byte &currentPallette, const byte *&colors)
+{
+	if (pallette != currentPallette)
+	{
+		currentPallette = pallette;
+		colors = palletteColors[palletteId][pallette];
+	}
+}
+
+void LineRenderer::writePalletteData(const byte palletteSet, const byte byteWritten)
+{
+	// Same index handling as Memory, which sees the same writes in the same order
+	byte *pallettes = cgbPallettes[palletteSet];
+	const byte specification = cgbPalletteIndices[palletteSet];
+	const byte index = specification & 0x3F;
+	pallettes[index] = byteWritten;
+	if ((specification & 0x80) == 0x80)
+	{
+		cgbPalletteIndices[palletteSet] = 0x80 | ((index + 1) & 0x3F);
+	}
+
+	// Colors are two little endian bytes, only the one this byte belongs to changes
+	const byte color = index & 0x3E;
+	const size rgb555 = (pallettes[color] | (pallettes[color + 1] << 8)) & 0x7FFF;
+	cgbColors[palletteSet * 32 + color / 2] = rgb555Colors[rgb555];
+}
+
+void LineRenderer::beginFrame()
+{
+	buildSpriteLines();
+	windowLine = 0;
+}
+
+void LineRenderer::renderLine(const byte line)
+{
+	byte bgIndices[160];
+	byte *linePixels = framebuffer + line * 160;
+	renderBackground(line, bgIndices, linePixels);
+	if (spriteSizeDisplayEnabled && lineSpriteCounts[line] > 0)
+	{
+		byte spriteLine[160];
+		renderSprites(line, bgIndices, spriteLine);
+		LineCompositor::compose(linePixels, bgIndices, spriteLine, 160);
+	}
+}
+
+void LineRenderer::renderBackground(const byte line, byte *bgIndices, byte *linePixels)
+{
+	if (!bgCgbDisplay && !cgbMode) // Background and window off, DMG shows white and sprites are always on top
+	{
+		for (byte x = 0; x < 160; x++)
+		{
+			bgIndices[x] = 0x00;
+			linePixels[x] = palletteColors[BG_PALLETTE_ID][0x00][0];
+		}
+		return;
+	}
+
+	// The window covers everything right of WX-7 once LY reaches WY, those pixels never fetch the background
+	const int windowStartX = static_cast<int> (windowX) - 7;
+	const bool windowVisible = lcdWindowDisplayEnabled && line >= windowY && windowStartX < 160;
+	const byte backgroundEndX = windowVisible ? static_cast<byte> (windowStartX < 0 ? 0 : windowStartX) : 160;
+
+	const address bgTileMap = lcdBgTileMapDisplaySelect ? 0x9C00 : 0x9800; // 9C00-9FFF or 9800-9BFF
+	// Only the 160 visible pixels are fetched, SCX/SCY wrap around the 256x256 map
+	const byte bgMapY = static_cast<byte> (line + scrollY);
+	if (cgbMode)
+	{
+		renderCgbTiles(bgTileMap, scrollX, bgMapY, 0, backgroundEndX, bgIndices, linePixels);
+	}
+	else
+	{
+		renderTiles(bgTileMap, scrollX, bgMapY, 0, backgroundEndX, bgIndices, linePixels);
+	}
+	if (windowVisible)
+	{
+		const address windowTileMap = lcdWindowTileMapSelect ? 0x9C00 : 0x9800;
+		const byte windowMapX = static_cast<byte> (backgroundEndX - windowStartX);
+		if (cgbMode)
+		{
+			renderCgbTiles(windowTileMap, windowMapX, windowLine, backgroundEndX, 160, bgIndices, linePixels);
+		}
+		else
+		{
+			renderTiles(windowTileMap, windowMapX, windowLine, backgroundEndX, 160, bgIndices, linePixels);
+		}
+		windowLine++; // The window keeps its own line counter, it only advances on lines it is drawn
+	}
+
+	if (!bgCgbDisplay) // CGB still draws the background, it just loses all priority over sprites
+	{
+		memset(bgIndices, 0x00, 160);
+	}
+}
+
+void LineRenderer::renderTiles(const address tileMap, const byte mapX, const byte mapY,
+	const byte startX, const byte endX, byte *bgIndices, byte *linePixels) const
+{
+	const byte *tileMapRow = vram + (tileMap - 0x8000) + (mapY / 8) * 32;
+	const byte tileLine = mapY % 8;
+
+	byte x = startX;
+	byte currentMapX = mapX;
+	while (x < endX)
+	{
+		const byte tileNum = tileMapRow[currentMapX / 8];
+
+		// lcdWindowBgTileSelect == true : $8000-$8FFF with unsigned pattern
+		// else : $8800-$97FF with signed pattern
+		const address currentTile = lcdWindowBgTileSelect ?
+			0x8000 + (tileNum * 16):
+			0x9000 + (static_cast<signed char> (tileNum) * 16);
+
+		const byte *tilePixels = tileCache.getRow(0, currentTile + tileLine * 2);
+		for (byte pixel = currentMapX % 8; pixel < 8 && x < endX; pixel++)
+		{
+			bgIndices[x] = tilePixels[pixel];
+			linePixels[x] = bgColors[tilePixels[pixel]];
+			x++;
+			currentMapX++;
+		}
+	}
+}
+
+void LineRenderer::renderCgbTiles(const address tileMap, const byte mapX, const byte mapY,
+	const byte startX, const byte endX, byte *bgIndices, byte *linePixels) const
+{
+	// Bank 1 holds the attributes of the tile at the same map position in bank 0
+	const size mapRowOffset = (tileMap - 0x8000) + (mapY / 8) * 32;
+	const byte *tileMapRow = vram + mapRowOffset;
+	const byte *attributeRow = vram + 0x2000 + mapRowOffset;
+
+	byte x = startX;
+	byte currentMapX = mapX;
+	while (x < endX)
+	{
+		const byte tileNum = tileMapRow[currentMapX / 8];
+		const byte attributes = attributeRow[currentMapX / 8];
+		const address currentTile = lcdWindowBgTileSelect ?
+			0x8000 + (tileNum * 16):
+			0x9000 + (static_cast<signed char> (tileNum) * 16);
+		const byte tileLine = (attributes & 0x40) == 0x40 ? 7 - mapY % 8 : mapY % 8;
+		const byte flipX = (attributes & 0x20) == 0x20 ? 0x07 : 0x00;
+		const byte *indices = cgbBgIndices[attributes >> 7];
+		const byte *colors = cgbPalletteColors[attributes & 0x07];
+
+		const byte *tilePixels = tileCache.getRow((attributes >> 3) & 0x01, currentTile + tileLine * 2);
+		for (byte pixel = currentMapX % 8; pixel < 8 && x < endX; pixel++)
+		{
+			const byte colorIndex = tilePixels[pixel ^ flipX];
+			bgIndices[x] = indices[colorIndex];
+			linePixels[x] = colors[colorIndex];
+			x++;
+			currentMapX++;
+		}
+	}
+}
+
+void LineRenderer::buildSpriteLines()
+{
+	const byte spriteHeight = spriteSizeDetermine ? 16 : 8;
+	for (byte line = 0; line < 144; line++)
+	{
+		lineSpriteCounts[line] = 0;
+	}
+
+	// The hardware picks the first 10 sprites in OAM order that overlap a line
+	for (byte sprite = 0; sprite < 40; sprite++)
+	{
+		const int spriteY = static_cast<int> (oam[sprite * 4]) - 16;
+		for (int line = spriteY < 0 ? 0 : spriteY; line < spriteY + spriteHeight && line < 144; line++)
+		{
+			if (lineSpriteCounts[line] < 10)
+			{
+				lineSprites[line][lineSpriteCounts[line]] = sprite;
+				lineSpriteCounts[line]++;
+			}
+		}
+	}
+
+	if (cgbMode) // CGB draws them in OAM order only
+	{
+		return;
+	}
+
+	// Then draws them by lowest X first, ties going to the lower OAM index. Insertion sort keeps OAM order on ties.
+	for (byte line = 0; line < 144; line++)
+	{
+		byte *sprites = lineSprites[line];
+		for (byte i = 1; i < lineSpriteCounts[line]; i++)
+		{
+			const byte sprite = sprites[i];
+			const byte spriteX = oam[sprite * 4 + 0x01];
+			byte j = i;
+			while (j > 0 && oam[sprites[j - 1] * 4 + 0x01] > spriteX)
+			{
+				sprites[j] = sprites[j - 1];
+				j--;
+			}
+			sprites[j] = sprite;
+		}
+	}
+}
+
+void LineRenderer::renderSprites(const byte line, const byte *bgIndices, byte *spriteLine) const
+{
+	const byte spriteHeight = spriteSizeDetermine ? 16 : 8;
+	memset(spriteLine, 0x00, 160);
+
+	for (byte i = 0; i < lineSpriteCounts[line]; i++)
+	{
+		const byte *sprite = oam + lineSprites[line][i] * 4;
+		const int spriteX = static_cast<int> (sprite[0x01]) - 8;
+		const byte attributes = sprite[0x03];
+		const byte priority = (attributes & 0x80) == 0x80 ? LineCompositor::SPRITE_BEHIND_BG : 0x00;
+		const bool flipY = (attributes & 0x40) == 0x40;
+		const bool flipX = (attributes & 0x20) == 0x20;
+		const byte *colors = (attributes & 0x10) == 0x10 ? objColors1 : objColors0;
+		byte tileBank = 0;
+		if (cgbMode)
+		{
+			colors = cgbPalletteColors[8 + (attributes & 0x07)];
+			tileBank = (attributes >> 3) & 0x01;
+		}
+
+		byte tileLine = static_cast<byte> (line - (static_cast<int> (sprite[0x00]) - 16));
+		if (flipY)
+		{
+			tileLine = spriteHeight - 1 - tileLine;
+		}
+		byte tileNum = sprite[0x02];
+		if (spriteHeight == 16)
+		{
+			tileNum = (tileNum & 0xFE) | (tileLine >> 3);
+		}
+		const byte *tilePixels = tileCache.getRow(tileBank, 0x8000 + tileNum * 16 + (tileLine & 0x07) * 2);
+
+		for (byte pixel = 0; pixel < 8; pixel++)
+		{
+			const int x = spriteX + pixel;
+			if (x < 0 || x >= 160 || spriteLine[x] != 0x00)
+			{
+				continue;
+			}
+			const byte colorIndex = tilePixels[flipX ? 7 - pixel : pixel];
+			if (colorIndex == 0x00) // Transparent, lower priority sprites can still show through
+			{
+				continue;
+			}
+			// The highest priority opaque sprite pixel owns the pixel even when the background hides it,
+			// whether it shows is left to the compositor
+			const byte bgPriority = (bgIndices[x] & BG_OVER_OBJ) == BG_OVER_OBJ ? LineCompositor::SPRITE_BEHIND_BG : 0x00;
+			spriteLine[x] = LineCompositor::SPRITE_OPAQUE | priority | bgPriority | colors[colorIndex];
+		}
+	}
+}
+
+void LineRenderer::present(Screen &screen) const
+{
+	// The presenter thread uploads and shows the frame, rendering carries on right away
+	Frame *frame = screen.getBackFrame();
+	memcpy(frame->pixels, framebuffer, sizeof(frame->pixels));
+	// CGB pallette writes in the middle of a frame show up once it is presented
+	memcpy(frame->colors, cgbMode ? cgbColors : dmgColors, sizeof(frame->colors));
+	screen.publishFrame();
+}
+
+static void buildPalletteColors()
+{
+	for (byte palletteId = 0; palletteId < 3; palletteId++)
+	{
+		for (size pallette = 0; pallette < 256; pallette++)
+		{
+			for (byte colorIndex = 0; colorIndex < 4; colorIndex++)
+			{
+				const byte shade = (pallette >> (colorIndex * 2)) & 0x03;
+				palletteColors[palletteId][pallette][colorIndex] = static_cast<byte> (shade | (palletteId << 2));
+			}
+		}
+	}
+
+	const byte shades[4] = { 255, 170, 85, 0 }; // white, light gray, dark gray, black
+	for (byte value = 0; value < 64; value++)
+	{
+		const byte shade = shades[value & 0x03];
+		// RGBA8888 packs red into the most significant byte
+		dmgColors[value] = (static_cast<Uint32> (shade) << 24) |
+			(static_cast<Uint32> (shade) << 16) | (static_cast<Uint32> (shade) << 8) | 0xFF;
+	}
+
+	for (byte pallette = 0; pallette < 16; pallette++)
+	{
+		for (byte colorIndex = 0; colorIndex < 4; colorIndex++)
+		{
+			cgbPalletteColors[pallette][colorIndex] = static_cast<byte> (colorIndex | (pallette << 2));
+		}
+	}
+	for (size rgb555 = 0; rgb555 < 0x8000; rgb555++)
+	{
+		// 5 bits to 8 by repeating the top bits, so 0x1F is full intensity
+		const Uint32 red = rgb555 & 0x1F;
+		const Uint32 green = (rgb555 >> 5) & 0x1F;
+		const Uint32 blue = (rgb555 >> 10) & 0x1F;
+		rgb555Colors[rgb555] = (((red << 3) | (red >> 2)) << 24) |
+			(((green << 3) | (green >> 2)) << 16) | (((blue << 3) | (blue >> 2)) << 8) | 0xFF;
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef _GAHOOD_BOY_LINE_RENDERER_HPP_
+#define _GAHOOD_BOY_LINE_RENDERER_HPP_
+
+#include "memory.hpp"
+#include "screen.hpp"
+#include "tile_cache.hpp"
+
+/*
+* Turns LCD state into frame pixels one line at a time. It keeps its own copy of VRAM
+* (with the decoded tile cache), OAM and the LCD registers, which only change through
+* write(), so it never touches Memory after construction and can run on any thread.
+* In CGB mode frame pixel values are a color index | pallette << 2, with the 8 BG pallettes
+* first and the 8 OBJ pallettes after them, and the frame colors are the pallette RAM
+* converted through an RGB555 lookup table as it is written.
+*/
+class LineRenderer
+{
+public:
+	LineRenderer(const Memory &memory);
+	~LineRenderer();
+
+	// VRAM 0x8000-0x9FFF, OAM 0xFE00-0xFE9F, the LCD registers 0xFF40-0xFF4B and the CGB ones Memory reports
+	void write(const address addr, const byte byteWritten);
+	// A run of VRAM bytes from a VRAM DMA, it stays within VRAM
+	void writeBlock(const address addr, const byte *bytes, const size length);
+	void beginFrame();
+	void renderLine(const byte line);
+	void present(Screen &screen) const;
+
+private:
+	byte *framebuffer; // Frame pixel values, see Frame
+	byte *vram; // Both banks, the CGB tile attributes are the tile maps of bank 1
+	byte vramBank;
+	byte oam[0xA0];
+	TileCache tileCache;
+
+	bool lcdWindowTileMapSelect;
+	bool lcdWindowDisplayEnabled;
+	bool lcdWindowBgTileSelect;
+	bool lcdBgTileMapDisplaySelect;
+	bool spriteSizeDetermine;
+	bool spriteSizeDisplayEnabled;
+	bool bgCgbDisplay;
+
+	byte scrollX;
+	byte scrollY;
+	byte windowX; // WX, the window starts at WX-7
+	byte windowY;
+	byte bgPallette;
+	byte objPallette0;
+	byte objPallette1;
+	const byte *bgColors;
+	const byte *objColors0;
+	const byte *objColors1;
+
+	bool cgbMode;
+	byte cgbPallettes[2][0x40]; // BG and OBJ pallette RAM
+	byte cgbPalletteIndices[2]; // BCPS and OCPS
+	Uint32 cgbColors[64]; // RGBA8888 of every CGB frame pixel value
+
+	byte lineSprites[144][10]; // OAM indices visible on each line, in drawing priority order
+	byte lineSpriteCounts[144];
+	byte windowLine;
+
+	LineRenderer(const LineRenderer &other);
+	LineRenderer& operator=(const LineRenderer &other);
+
+	void writeRegister(const address addr, const byte byteWritten);
+	void renderBackground(const byte line, byte *bgIndices, byte *linePixels);
+	void renderTiles(const address tileMap, const byte mapX, const byte mapY,
+		const byte startX, const byte endX, byte *bgIndices, byte *linePixels) const;
+	void renderCgbTiles(const address tileMap, const byte mapX, const byte mapY,
+		const byte startX, const byte endX, byte *bgIndices, byte *linePixels) const;
+	void buildSpriteLines();
+	void renderSprites(const byte line, const byte *bgIndices, byte *spriteLine) const;
+	void writePalletteData(const byte palletteSet, const byte byteWritten);
+	void updatePallette(const byte pallette, const byte palletteId, byte &currentPallette, const byte *&colors);
+};
+
+#endif
@@ -1,53 +1,113 @@
 #include "memory.hpp"
+#include "memory_map.hpp"
+#include "memory_guard.hpp"
 
-Memory::Memory(const Cartridge &cartridge)
+#include <cstring>
+
+static const size ROM_BANK_SIZE = 0x4000;
+static const size RAM_BANK_SIZE = 0x2000;
+static const size VRAM_BANK_SIZE = 0x2000;
+
+static MbcType readMbcType(const byte cartridgeType);
+
+Memory::Memory(const Cartridge &cartridge, const bool romGuard)
 {
     memorySize = 0xFFFF;
-    memoryBytes = (byte *) malloc(sizeof(byte) * (static_cast<unsigned long> (memorySize) + 0x01));
-    for(size i = 0x0000; i <= memorySize; i += 0x0001)
+    romBytes = cartridge.getCartridgeMemory();
+    romSize = cartridge.getCartridgeMemorySize();
+    romBankCount = (romSize + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE;
+    romBank = 1;
+    ramBankCount = (cartridge.getRamSize() + RAM_BANK_SIZE - 1) / RAM_BANK_SIZE;
+    ramBank = 0;
+    ramBanks = NULL;
+    mbcType = readMbcType(cartridge.getCartridgeType());
+    mbc1BankLow = 0x01;
+    mbc1BankHigh = 0x00;
+    mbc1RamBanking = false;
+    mbc5BankLow = 0x01;
+    mbc5BankHigh = 0x00;
+    memoryGuard = NULL;
+    writeFunction = &Memory::writeChecked;
+    watchpointCount = 0;
+    videoWriteCallback = NULL;
+    videoBlockWriteCallback = NULL;
+    videoWriteOwner = NULL;
+    cgbMode = cartridge.isCgbEnabled();
+    vramBanks = NULL;
+    vramBank = 0;
+    // The CGB boot ROM leaves every pallette white
+    memset(cgbPallettes, 0xFF, sizeof(cgbPallettes));
+    doubleSpeed = false;
+    vramDmaSource = 0x0000;
+    vramDmaDestination = 0x8000;
+    hblankDmaBlocks = 0;
+
+    memoryMap = MemoryMap::create(romBytes, romSize, cartridge.getRamSize());
+    if(memoryMap)
     {
-        if(i <= 0x8000)
+        Gahood::log("Using the memfd backed address space");
+        memoryBytes = memoryMap->getAddressSpace();
+        softwareEchoStart = 0xD000;
+        if(romGuard)
         {
-            memoryBytes[i] = cartridge.getCartridgeMemory()[i];
+            memoryGuard = MemoryGuard::create(memoryBytes);
         }
-        else
+        if(memoryGuard)
+        {
+            Gahood::log("ROM writes are trapped by guard pages");
+            memoryMap->setRomReadOnly();
+            memoryGuard->protectPages(0x0000, 0x8000, true);
+            writeFunction = &Memory::store;
+        }
+    }
+    else
+    {
+        if(romGuard)
+        {
+            Gahood::log("Guard pages need the memfd backed address space, ignoring");
+        }
+        memoryBytes = (byte *) malloc(sizeof(byte) * (static_cast<unsigned long> (memorySize) + 0x01));
+        for(size i = 0x0000; i <= memorySize; i += 0x0001)
+        {
+            if(i < 0x8000)
+            {
+                memoryBytes[i] = cartridge.getCartridgeMemory()[i];
+            }
+            else
+            {
+                memoryBytes[i] = 0x00;
+            }
+        }
+        if(ramBankCount > 0)
+        {
+            ramBanks = (byte *) calloc(ramBankCount * RAM_BANK_SIZE, sizeof(byte));
+        }
+        if(cgbMode)
         {
-            memoryBytes[i] = 0x00;
+            vramBanks = (byte *) calloc(2 * VRAM_BANK_SIZE, sizeof(byte));
         }
+        softwareEchoStart = 0xC000;
     }
 }
 
 Memory::Memory(const Memory &other)
 {
-    memorySize = 0xFFFF;
-    memoryBytes = (byte *) malloc(sizeof(byte) * (static_cast<unsigned long> (memorySize) + 0x01));
-    for(size i = 0x0000; i <= memorySize; i += 0x0001)
-    {
-        memoryBytes[i] = other.memoryBytes[i];
-    }
+    copyFrom(other);
 }
 
 Memory& Memory::operator=(const Memory &other)
 {
-    if(memoryBytes)
-    {
-        free(memoryBytes);
-    }
-    memorySize = 0xFFFF;
-    memoryBytes = (byte *) malloc(sizeof(byte) * (static_cast<unsigned long> (memorySize) + 0x01));
-    for(size i = 0x0000; i <= memorySize; i += 0x0001)
+    if(this != &other)
     {
-        memoryBytes[i] = other.memoryBytes[i];
+        release();
+        copyFrom(other);
     }
     return *this;
 }
 
 Memory::~Memory()
 {
-    if(memoryBytes)
-    {
-        free(memoryBytes);
-    }
+    release();
     memorySize = 0x0000;
 }
 
@@ -56,16 +116,23 @@ byte Memory::read(const address addr) const
     return memoryBytes[addr];
 }
 
-void Memory::write(const address addr, const byte byteToWrite)
+void Memory::writeChecked(const address addr, const byte byteToWrite)
 {
     if(addr > memorySize)
     {
         Gahood::criticalError("Attempted to write to memory at out of bounds address %x", addr & 0xFFFF);
     }
-	if (addr < 8000)
-	{
-		Gahood::log("Attempted to write to memory at Cartridge ROM area %x", addr & 0xFFFF);
-	}
+    if(addr < 0x8000)
+    {
+        writeBankControl(addr, byteToWrite);
+        return;
+    }
+    store(addr, byteToWrite);
+}
+
+// Every store is a single byte, which is all a guard page trap can report
+void Memory::store(const address addr, const byte byteToWrite)
+{
 	switch (addr)
 	{
     case 0xFF04: // Timer Divider Register
@@ -83,21 +150,530 @@ void Memory::write(const address addr, const byte byteToWrite)
 	case 0xFF46: // LCD OAM DMA Transfers
 	{
 		const address startAddr = static_cast<address> (byteToWrite << 8);
-		const address endAddr = startAddr | 0x9F;
-		for (size wrAddr = startAddr; wrAddr <= endAddr; wrAddr += 0x01)
+		copyBlock(0xFE00, startAddr, 0xA0);
+		for (address oamAddr = 0xFE00; oamAddr < 0xFEA0; oamAddr++)
 		{
-			memoryBytes[(wrAddr & 0x00FF) | 0xFE00] = memoryBytes[wrAddr];
+			notifyVideoWrite(oamAddr, memoryBytes[oamAddr]);
 		}
 		break;
 	}
+	case 0xFF4F: // VBK, CGB VRAM bank select
+		if(cgbMode)
+		{
+			switchVramBank(byteToWrite & 0x01);
+			memoryBytes[addr] = 0xFE | vramBank;
+			notifyVideoWrite(addr, byteToWrite);
+			break;
+		}
+		memoryBytes[addr] = byteToWrite;
+		break;
+	case 0xFF4D: // KEY1, only the switch request bit is writable, STOP does the switch
+		if(cgbMode)
+		{
+			memoryBytes[addr] = (doubleSpeed ? 0x80 : 0x00) | 0x7E | (byteToWrite & 0x01);
+			break;
+		}
+		memoryBytes[addr] = byteToWrite;
+		break;
+	case 0xFF55: // HDMA5, starts or stops a VRAM DMA from HDMA1-HDMA4
+		if(cgbMode)
+		{
+			startVramDma(byteToWrite);
+			break;
+		}
+		memoryBytes[addr] = byteToWrite;
+		break;
+	case 0xFF68: // BCPS, CGB BG pallette index
+	case 0xFF6A: // OCPS, CGB OBJ pallette index
+		memoryBytes[addr] = byteToWrite;
+		if(cgbMode)
+		{
+			memoryBytes[addr + 1] = cgbPallettes[(addr - 0xFF68) / 2][byteToWrite & 0x3F];
+			notifyVideoWrite(addr, byteToWrite);
+		}
+		break;
+	case 0xFF69: // BCPD, CGB BG pallette data
+	case 0xFF6B: // OCPD, CGB OBJ pallette data
+		if(cgbMode)
+		{
+			writePalletteData(addr, byteToWrite);
+			notifyVideoWrite(addr, byteToWrite);
+			break;
+		}
+		memoryBytes[addr] = byteToWrite;
+		break;
 	default:
+	{
 		memoryBytes[addr] = byteToWrite;
+		if(static_cast<address> (addr - 0x8000) < 0x2000 || // VRAM
+			static_cast<address> (addr - 0xFE00) < 0xA0 || // OAM
+			static_cast<address> (addr - 0xFF40) < 0x0C) // LCDC through WX
+		{
+			notifyVideoWrite(addr, byteToWrite);
+		}
+		// Echo RAM 0xE000-0xFDFF mirrors 0xC000-0xDDFF
+		const address wramAddr = addr & 0xDFFF;
+		if(wramAddr >= softwareEchoStart && wramAddr < 0xDE00)
+		{
+			memoryBytes[addr ^ 0x2000] = byteToWrite;
+		}
         break;
 	}
+	}
 }
 
 void Memory::dumpToFile(const char *filePath) const
 {
     Gahood::log("Dumping last memory state to %s", filePath);
     Gahood::writeToFile(filePath, memoryBytes, static_cast<size> (memorySize));
-}
\ No newline at end of file
+}
+
+bool Memory::isCgbMode() const
+{
+    return cgbMode;
+}
+
+bool Memory::isDoubleSpeed() const
+{
+    return doubleSpeed;
+}
+
+bool Memory::switchSpeed()
+{
+    if(!cgbMode || (memoryBytes[0xFF4D] & 0x01) == 0x00)
+    {
+        return false;
+    }
+    doubleSpeed = !doubleSpeed;
+    memoryBytes[0xFF4D] = (doubleSpeed ? 0x80 : 0x00) | 0x7E;
+    return true;
+}
+
+void Memory::runHblankDma()
+{
+    if(hblankDmaBlocks == 0)
+    {
+        return;
+    }
+    copyVramDmaBlocks(1);
+    hblankDmaBlocks--;
+    // HDMA5 counts down the blocks left minus one and reads 0xFF once done
+    memoryBytes[0xFF55] = hblankDmaBlocks == 0 ? 0xFF : hblankDmaBlocks - 1;
+}
+
+void Memory::setVideoWriteCallback(VideoWriteCallback callback, VideoBlockWriteCallback blockCallback, void *owner)
+{
+    videoWriteCallback = callback;
+    videoBlockWriteCallback = blockCallback;
+    videoWriteOwner = owner;
+}
+
+void Memory::addWatchpoint(const address addr)
+{
+    if(!memoryGuard)
+    {
+        Gahood::log("Watchpoints need the guard page mode, ignoring watchpoint at %x", addr & 0xFFFF);
+        return;
+    }
+    if(watchpointCount == sizeof(watchpoints) / sizeof(watchpoints[0]))
+    {
+        Gahood::log("Too many watchpoints, ignoring watchpoint at %x", addr & 0xFFFF);
+        return;
+    }
+    // Echo RAM is watched through the WRAM it mirrors, the host mirrored part of it is a page of its own
+    const address wramAddr = addr >= 0xE000 && addr < 0xFE00 ? addr - 0x2000 : addr;
+    watchpoints[watchpointCount] = wramAddr;
+    watchpointCount++;
+    memoryGuard->protectPages(wramAddr, 0x0001, false);
+    if(wramAddr >= 0xC000 && wramAddr < softwareEchoStart)
+    {
+        memoryGuard->protectPages(wramAddr + 0x2000, 0x0001, false);
+    }
+}
+
+void Memory::handleTrappedWrites()
+{
+    if(!memoryGuard)
+    {
+        return;
+    }
+    if(memoryGuard->hasDroppedWrites())
+    {
+        Gahood::criticalError("More writes were trapped in one instruction than the guard pages can queue");
+    }
+    // The guard only queues the stores it trapped, the bank switches and logging happen here once they returned.
+    // Video already heard of them from store(), which notifies after its own store whether it trapped or not
+    address addr;
+    byte byteWritten;
+    while(memoryGuard->takeTrappedWrite(addr, byteWritten))
+    {
+        logWatchpointHit(addr, byteWritten);
+        if(addr < 0x8000)
+        {
+            writeBankControl(addr, byteWritten);
+        }
+    }
+}
+
+void Memory::logWatchpointHit(const address addr, const byte byteWritten) const
+{
+    const address wramAddr = addr >= 0xE000 && addr < 0xFE00 ? addr - 0x2000 : addr;
+    for(byte i = 0; i < watchpointCount; i++)
+    {
+        if(watchpoints[i] == wramAddr)
+        {
+            Gahood::log("Watchpoint hit: wrote %x to %x", byteWritten & 0xFF, addr & 0xFFFF);
+        }
+    }
+}
+
+void Memory::copyBlock(const address destination, const address source, const size length)
+{
+    if(!memoryGuard)
+    {
+        memmove(memoryBytes + destination, memoryBytes + source, length);
+        return;
+    }
+    // A trap only sees the first byte of a wide store, so block copies lift the guard and report watchpoints themselves
+    memoryGuard->unprotectPages(destination, length);
+    memmove(memoryBytes + destination, memoryBytes + source, length);
+    memoryGuard->reprotectPages(destination, length);
+    for(byte i = 0; i < watchpointCount; i++)
+    {
+        if(static_cast<address> (watchpoints[i] - destination) < length)
+        {
+            Gahood::log("Watchpoint hit: wrote %x to %x", memoryBytes[watchpoints[i]] & 0xFF, watchpoints[i] & 0xFFFF);
+        }
+    }
+}
+
+void Memory::writeBankControl(const address addr, const byte byteToWrite)
+{
+    // Writes to 0x0000-0x1FFF (RAM enable) are ignored on purpose, cartridge RAM is always accessible
+    switch(mbcType)
+    {
+    case MBC_1:
+        if(addr >= 0x2000 && addr < 0x4000)
+        {
+            mbc1BankLow = byteToWrite & 0x1F;
+            switchRomBank(getMbc1RomBank());
+        }
+        else if(addr >= 0x4000 && addr < 0x6000)
+        {
+            mbc1BankHigh = byteToWrite & 0x03;
+            switchRomBank(getMbc1RomBank());
+            switchRamBank(mbc1RamBanking ? mbc1BankHigh : 0);
+        }
+        else if(addr >= 0x6000)
+        {
+            mbc1RamBanking = (byteToWrite & 0x01) == 0x01;
+            switchRamBank(mbc1RamBanking ? mbc1BankHigh : 0);
+        }
+        break;
+    case MBC_2:
+        if(addr < 0x4000 && (addr & 0x0100) == 0x0100)
+        {
+            const byte bank = byteToWrite & 0x0F;
+            switchRomBank(bank == 0x00 ? 0x01 : bank);
+        }
+        break;
+    case MBC_3:
+        if(addr >= 0x2000 && addr < 0x4000)
+        {
+            const byte bank = byteToWrite & 0x7F;
+            switchRomBank(bank == 0x00 ? 0x01 : bank);
+        }
+        else if(addr >= 0x4000 && addr < 0x6000 && byteToWrite <= 0x03) // 0x08-0x0C select the RTC registers
+        {
+            switchRamBank(byteToWrite);
+        }
+        break;
+    case MBC_5:
+        if(addr >= 0x2000 && addr < 0x3000)
+        {
+            mbc5BankLow = byteToWrite;
+            switchRomBank((static_cast<size> (mbc5BankHigh) << 8) | mbc5BankLow);
+        }
+        else if(addr >= 0x3000 && addr < 0x4000)
+        {
+            mbc5BankHigh = byteToWrite & 0x01;
+            switchRomBank((static_cast<size> (mbc5BankHigh) << 8) | mbc5BankLow);
+        }
+        else if(addr >= 0x4000 && addr < 0x6000)
+        {
+            switchRamBank(byteToWrite & 0x0F);
+        }
+        break;
+    default:
+        if(Gahood::isVerboseMode())
+        {
+            Gahood::log("Ignoring write to Cartridge ROM area %x", addr & 0xFFFF);
+        }
+        break;
+    }
+}
+
+size Memory::getMbc1RomBank() const
+{
+    // Bank 0 can't be selected for 0x4000-0x7FFF, only the low 5 bits are checked for it
+    return (static_cast<size> (mbc1BankHigh) << 5) | (mbc1BankLow == 0x00 ? 0x01 : mbc1BankLow);
+}
+
+void Memory::switchRomBank(const size bank)
+{
+    const size bankToMap = bank % romBankCount;
+    if(bankToMap == romBank)
+    {
+        return;
+    }
+    romBank = bankToMap;
+    if(memoryMap)
+    {
+        memoryMap->mapRomBank(romBank);
+        return;
+    }
+    const size bankOffset = romBank * ROM_BANK_SIZE;
+    const size bankSize = romSize - bankOffset < ROM_BANK_SIZE ? romSize - bankOffset : ROM_BANK_SIZE;
+    memcpy(memoryBytes + 0x4000, romBytes + bankOffset, bankSize);
+}
+
+void Memory::switchRamBank(const size bank)
+{
+    if(ramBankCount == 0)
+    {
+        return;
+    }
+    const size bankToMap = bank % ramBankCount;
+    if(bankToMap == ramBank)
+    {
+        return;
+    }
+    if(memoryMap)
+    {
+        memoryMap->mapRamBank(bankToMap);
+        if(memoryGuard)
+        {
+            memoryGuard->reprotectPages(0xA000, RAM_BANK_SIZE);
+        }
+    }
+    else
+    {
+        memcpy(ramBanks + ramBank * RAM_BANK_SIZE, memoryBytes + 0xA000, RAM_BANK_SIZE);
+        memcpy(memoryBytes + 0xA000, ramBanks + bankToMap * RAM_BANK_SIZE, RAM_BANK_SIZE);
+    }
+    ramBank = bankToMap;
+}
+
+void Memory::switchVramBank(const byte bank)
+{
+    if(bank == vramBank)
+    {
+        return;
+    }
+    if(memoryMap)
+    {
+        memoryMap->mapVramBank(bank);
+        if(memoryGuard)
+        {
+            memoryGuard->reprotectPages(0x8000, VRAM_BANK_SIZE);
+        }
+    }
+    else
+    {
+        memcpy(vramBanks + vramBank * VRAM_BANK_SIZE, memoryBytes + 0x8000, VRAM_BANK_SIZE);
+        memcpy(memoryBytes + 0x8000, vramBanks + bank * VRAM_BANK_SIZE, VRAM_BANK_SIZE);
+    }
+    vramBank = bank;
+}
+
+void Memory::writePalletteData(const address dataAddr, const byte byteToWrite)
+{
+    byte *pallettes = cgbPallettes[(dataAddr - 0xFF69) / 2];
+    const byte specification = memoryBytes[dataAddr - 1];
+    pallettes[specification & 0x3F] = byteToWrite;
+    if((specification & 0x80) == 0x80) // Auto increment, the index wraps within the 64 bytes
+    {
+        memoryBytes[dataAddr - 1] = 0x80 | ((specification + 1) & 0x3F);
+    }
+    memoryBytes[dataAddr] = pallettes[memoryBytes[dataAddr - 1] & 0x3F];
+}
+
+void Memory::startVramDma(const byte control)
+{
+    if(hblankDmaBlocks > 0 && (control & 0x80) == 0x00)
+    {
+        // Clearing bit 7 while an HBlank DMA runs stops it, the blocks left stay readable
+        hblankDmaBlocks = 0;
+        memoryBytes[0xFF55] |= 0x80;
+        return;
+    }
+
+    // Both addresses are 16 byte aligned and the destination always lands in VRAM
+    vramDmaSource = Gahood::addressFromBytes(memoryBytes[0xFF51], memoryBytes[0xFF52] & 0xF0);
+    vramDmaDestination = 0x8000 | Gahood::addressFromBytes(memoryBytes[0xFF53] & 0x1F, memoryBytes[0xFF54] & 0xF0);
+    const byte blockCount = (control & 0x7F) + 1;
+    if((control & 0x80) == 0x80)
+    {
+        hblankDmaBlocks = blockCount;
+        memoryBytes[0xFF55] = blockCount - 1;
+        return;
+    }
+    // General purpose DMA copies everything at once
+    copyVramDmaBlocks(blockCount);
+    memoryBytes[0xFF55] = 0xFF;
+}
+
+void Memory::copyVramDmaBlocks(const byte blockCount)
+{
+    size remaining = blockCount * 0x10;
+    while(remaining > 0)
+    {
+        // One host copy per contiguous run, the destination wraps within VRAM and the source at 0xFFFF
+        size run = remaining;
+        if(run > static_cast<size> (0xA000 - vramDmaDestination))
+        {
+            run = 0xA000 - vramDmaDestination;
+        }
+        if(run > 0x10000 - static_cast<size> (vramDmaSource))
+        {
+            run = 0x10000 - vramDmaSource;
+        }
+        copyBlock(vramDmaDestination, vramDmaSource, run);
+        notifyVideoBlockWrite(vramDmaDestination, run);
+        vramDmaSource = static_cast<address> (vramDmaSource + run);
+        vramDmaDestination = 0x8000 | ((vramDmaDestination + run) & 0x1FFF);
+        remaining -= run;
+    }
+}
+
+void Memory::notifyVideoWrite(const address addr, const byte byteWritten)
+{
+    if(videoWriteCallback)
+    {
+        videoWriteCallback(videoWriteOwner, addr, byteWritten);
+    }
+}
+
+void Memory::notifyVideoBlockWrite(const address addr, const size length)
+{
+    if(videoBlockWriteCallback)
+    {
+        videoBlockWriteCallback(videoWriteOwner, addr, memoryBytes + addr, length);
+    }
+}
+
+void Memory::copyFrom(const Memory &other)
+{
+    memorySize = 0xFFFF;
+    softwareEchoStart = other.softwareEchoStart;
+    romBytes = other.romBytes;
+    romSize = other.romSize;
+    romBankCount = other.romBankCount;
+    romBank = other.romBank;
+    ramBankCount = other.ramBankCount;
+    ramBank = other.ramBank;
+    ramBanks = NULL;
+    mbcType = other.mbcType;
+    mbc1BankLow = other.mbc1BankLow;
+    mbc1BankHigh = other.mbc1BankHigh;
+    mbc1RamBanking = other.mbc1RamBanking;
+    mbc5BankLow = other.mbc5BankLow;
+    mbc5BankHigh = other.mbc5BankHigh;
+    // Guard pages are process wide, copies always take the plain write path
+    memoryGuard = NULL;
+    writeFunction = &Memory::writeChecked;
+    watchpointCount = 0;
+    // The listener belongs to the original, a copy starts without one
+    videoWriteCallback = NULL;
+    videoBlockWriteCallback = NULL;
+    videoWriteOwner = NULL;
+    cgbMode = other.cgbMode;
+    vramBanks = NULL;
+    vramBank = other.vramBank;
+    memcpy(cgbPallettes, other.cgbPallettes, sizeof(cgbPallettes));
+    doubleSpeed = other.doubleSpeed;
+    vramDmaSource = other.vramDmaSource;
+    vramDmaDestination = other.vramDmaDestination;
+    hblankDmaBlocks = other.hblankDmaBlocks;
+
+    memoryMap = NULL;
+    if(other.memoryMap)
+    {
+        memoryMap = new MemoryMap(*other.memoryMap);
+        memoryBytes = memoryMap->getAddressSpace();
+        return;
+    }
+    memoryBytes = (byte *) malloc(sizeof(byte) * (static_cast<unsigned long> (memorySize) + 0x01));
+    for(size i = 0x0000; i <= memorySize; i += 0x0001)
+    {
+        memoryBytes[i] = other.memoryBytes[i];
+    }
+    if(other.ramBanks)
+    {
+        ramBanks = (byte *) malloc(sizeof(byte) * ramBankCount * RAM_BANK_SIZE);
+        memcpy(ramBanks, other.ramBanks, ramBankCount * RAM_BANK_SIZE);
+    }
+    if(other.vramBanks)
+    {
+        vramBanks = (byte *) malloc(sizeof(byte) * 2 * VRAM_BANK_SIZE);
+        memcpy(vramBanks, other.vramBanks, 2 * VRAM_BANK_SIZE);
+    }
+}
+
+void Memory::release()
+{
+    if(memoryGuard)
+    {
+        delete memoryGuard;
+        memoryGuard = NULL;
+    }
+    if(memoryMap)
+    {
+        delete memoryMap;
+        memoryMap = NULL;
+    }
+    else if(memoryBytes)
+    {
+        free(memoryBytes);
+    }
+    memoryBytes = NULL;
+    if(ramBanks)
+    {
+        free(ramBanks);
+        ramBanks = NULL;
+    }
+    if(vramBanks)
+    {
+        free(vramBanks);
+        vramBanks = NULL;
+    }
+}
+
+static MbcType readMbcType(const byte cartridgeType)
+{
+    switch(cartridgeType)
+    {
+    case 0x01:
+    case 0x02:
+    case 0x03:
+        return MBC_1;
+    case 0x05:
+    case 0x06:
+        return MBC_2;
+    case 0x0F:
+    case 0x10:
+    case 0x11:
+    case 0x12:
+    case 0x13:
+        return MBC_3;
+    case 0x19:
+    case 0x1A:
+    case 0x1B:
+    case 0x1C:
+    case 0x1D:
+    case 0x1E:
+        return MBC_5;
+    default:
+        return MBC_NONE;
+    }
+}
@@ -3,21 +3,100 @@
 
 #include "cartridge.hpp"
 
+class MemoryMap;
+class MemoryGuard;
+
+enum MbcType
+{
+    MBC_NONE,
+    MBC_1,
+    MBC_2,
+    MBC_3,
+    MBC_5
+};
+
 class Memory
 {
 public:
-    Memory(const Cartridge &cartridge);
+    typedef void (*VideoWriteCallback)(void *owner, const address addr, const byte byteWritten);
+    typedef void (*VideoBlockWriteCallback)(void *owner, const address addr, const byte *bytes, const size length);
+
+    Memory(const Cartridge &cartridge, const bool romGuard);
     Memory(const Memory &other);
     Memory& operator=(const Memory &other);
     ~Memory();
 
     byte read(const address addr) const;
-    void write(const address addr, const byte byteToWrite);
+    void write(const address addr, const byte byteToWrite) { (this->*writeFunction)(addr, byteToWrite); }
+    // Guard page mode routes ROM writes to the MBC and logs watchpoint hits here, once per emulated instruction
+    void handleTrappedWrites();
     void dumpToFile(const char *filePath) const;
+    void addWatchpoint(const address addr);
+    bool isCgbMode() const;
+    bool isDoubleSpeed() const;
+    // STOP, switches the CGB speed when KEY1 asked for it and reports whether it did
+    bool switchSpeed();
+    // Copies the next 16 bytes of a running HBlank DMA, Video calls it when each visible line enters H-Blank
+    void runHblankDma();
+    // Called after every write to VRAM, OAM (OAM DMA included), the LCD registers 0xFF40-0xFF4B
+    // and in CGB mode VBK and the pallette registers 0xFF68-0xFF6B, pass NULL to stop.
+    // VRAM DMA reports each contiguous run of 16 byte blocks to blockCallback instead
+    void setVideoWriteCallback(VideoWriteCallback callback, VideoBlockWriteCallback blockCallback, void *owner);
 
 private:
     byte *memoryBytes;
     address memorySize;
+    MemoryMap *memoryMap; // NULL when the flat buffer is used
+    address softwareEchoStart; // Start of the WRAM range whose echo is not already mirrored by the host MMU
+    MemoryGuard *memoryGuard; // NULL unless ROM writes are trapped by guard pages
+    typedef void (Memory::*WriteFunction)(const address addr, const byte byteToWrite);
+    WriteFunction writeFunction; // writeChecked, or store itself when the guard pages catch ROM writes
+    address watchpoints[16];
+    byte watchpointCount;
+    VideoWriteCallback videoWriteCallback;
+    VideoBlockWriteCallback videoBlockWriteCallback;
+    void *videoWriteOwner;
+
+    const byte *romBytes;
+    size romSize;
+    size romBankCount;
+    size romBank;
+    byte *ramBanks; // Switched out cartridge RAM banks, only used by the flat buffer
+    size ramBankCount;
+    size ramBank;
+    MbcType mbcType;
+    // Raw bank register values, the bank number is only reduced to the ROM size when it is mapped
+    byte mbc1BankLow;
+    byte mbc1BankHigh;
+    bool mbc1RamBanking;
+    byte mbc5BankLow;
+    byte mbc5BankHigh;
+
+    bool cgbMode;
+    byte *vramBanks; // Both CGB VRAM banks while switched out, only used by the flat buffer
+    byte vramBank;
+    byte cgbPallettes[2][0x40]; // BG and OBJ pallette RAM, read back through BCPD and OCPD
+    bool doubleSpeed;
+    address vramDmaSource;
+    address vramDmaDestination;
+    byte hblankDmaBlocks; // 16 byte blocks an HBlank DMA still has to copy, 0 when none runs
+
+    void writeChecked(const address addr, const byte byteToWrite);
+    void store(const address addr, const byte byteToWrite);
+    void copyBlock(const address destination, const address source, const size length);
+    void logWatchpointHit(const address addr, const byte byteWritten) const;
+    void writeBankControl(const address addr, const byte byteToWrite);
+    size getMbc1RomBank() const;
+    void switchRomBank(const size bank);
+    void switchRamBank(const size bank);
+    void switchVramBank(const byte bank);
+    void writePalletteData(const address dataAddr, const byte byteToWrite);
+    void startVramDma(const byte control);
+    void copyVramDmaBlocks(const byte blockCount);
+    void notifyVideoWrite(const address addr, const byte byteWritten);
+    void notifyVideoBlockWrite(const address addr, const size length);
+    void copyFrom(const Memory &other);
+    void release();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,264 @@
+#include "memory_guard.hpp"
+
+#if defined(GAHOOD_BOY_MEMFD) && (defined(__x86_64__) || defined(__i386__))
+
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <cstring>
+
+static const size GUARD_PAGE_SIZE = 0x1000;
+static const size GUARD_PAGE_COUNT = 0x10000 / GUARD_PAGE_SIZE;
+static const greg_t TRAP_FLAG = 0x100; // EFLAGS.TF, raises SIGTRAP after the next instruction
+
+enum PageMode
+{
+    PAGE_UNGUARDED,
+    PAGE_DISCARD_WRITES,
+    PAGE_WATCHED
+};
+
+static MemoryGuard *activeGuard = NULL;
+static struct sigaction previousSegvAction;
+static struct sigaction previousTrapAction;
+
+static void onSegmentationFault(int, siginfo_t *info, void *context);
+static void onTrap(int, siginfo_t *, void *context);
+
+MemoryGuard * MemoryGuard::create(byte *addressSpace)
+{
+    if(activeGuard)
+    {
+        Gahood::log("Only one address space can use guard pages at a time");
+        return NULL;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = onSegmentationFault;
+    if(sigaction(SIGSEGV, &action, &previousSegvAction) < 0)
+    {
+        Gahood::log("Failed to install the guard page SIGSEGV handler");
+        return NULL;
+    }
+    action.sa_sigaction = onTrap;
+    if(sigaction(SIGTRAP, &action, &previousTrapAction) < 0)
+    {
+        Gahood::log("Failed to install the guard page SIGTRAP handler");
+        sigaction(SIGSEGV, &previousSegvAction, NULL);
+        return NULL;
+    }
+
+    activeGuard = new MemoryGuard(addressSpace);
+    return activeGuard;
+}
+
+MemoryGuard::MemoryGuard(byte *addressSpace)
+{
+    this->addressSpace = addressSpace;
+    for(size page = 0; page < GUARD_PAGE_COUNT; page++)
+    {
+        pageModes[page] = PAGE_UNGUARDED;
+    }
+    trapPending = false;
+    trappedAddr = 0x0000;
+    trappedOriginal = 0x00;
+    pendingCount = 0;
+    pendingDropped = 0;
+    takenCount = 0;
+}
+
+MemoryGuard::~MemoryGuard()
+{
+    for(size page = 0; page < GUARD_PAGE_COUNT; page++)
+    {
+        if(pageModes[page] != PAGE_UNGUARDED)
+        {
+            mprotect(addressSpace + page * GUARD_PAGE_SIZE, GUARD_PAGE_SIZE, PROT_READ | PROT_WRITE);
+        }
+    }
+    sigaction(SIGSEGV, &previousSegvAction, NULL);
+    sigaction(SIGTRAP, &previousTrapAction, NULL);
+    activeGuard = NULL;
+}
+
+void MemoryGuard::protectPages(const address start, const size length, const bool discardWrites)
+{
+    const size lastPage = (start + length + GUARD_PAGE_SIZE - 1) / GUARD_PAGE_SIZE;
+    for(size page = start / GUARD_PAGE_SIZE; page < lastPage; page++)
+    {
+        if(pageModes[page] == PAGE_DISCARD_WRITES)
+        {
+            continue;
+        }
+        pageModes[page] = discardWrites ? PAGE_DISCARD_WRITES : PAGE_WATCHED;
+        if(mprotect(addressSpace + page * GUARD_PAGE_SIZE, GUARD_PAGE_SIZE, PROT_READ) < 0)
+        {
+            Gahood::criticalError("Failed to write protect the page at %x", static_cast<int> (page * GUARD_PAGE_SIZE));
+        }
+    }
+}
+
+void MemoryGuard::reprotectPages(const address start, const size length)
+{
+    const size lastPage = (start + length + GUARD_PAGE_SIZE - 1) / GUARD_PAGE_SIZE;
+    for(size page = start / GUARD_PAGE_SIZE; page < lastPage; page++)
+    {
+        if(pageModes[page] != PAGE_UNGUARDED &&
+            mprotect(addressSpace + page * GUARD_PAGE_SIZE, GUARD_PAGE_SIZE, PROT_READ) < 0)
+        {
+            Gahood::criticalError("Failed to write protect the page at %x", static_cast<int> (page * GUARD_PAGE_SIZE));
+        }
+    }
+}
+
+void MemoryGuard::unprotectPages(const address start, const size length)
+{
+    const size lastPage = (start + length + GUARD_PAGE_SIZE - 1) / GUARD_PAGE_SIZE;
+    for(size page = start / GUARD_PAGE_SIZE; page < lastPage; page++)
+    {
+        if(pageModes[page] != PAGE_UNGUARDED &&
+            mprotect(addressSpace + page * GUARD_PAGE_SIZE, GUARD_PAGE_SIZE, PROT_READ | PROT_WRITE) < 0)
+        {
+            Gahood::criticalError("Failed to unprotect the page at %x", static_cast<int> (page * GUARD_PAGE_SIZE));
+        }
+    }
+}
+
+bool MemoryGuard::hasDroppedWrites() const
+{
+    return pendingDropped != 0;
+}
+
+bool MemoryGuard::takeTrappedWrite(address &addr, byte &byteWritten)
+{
+    if(takenCount == pendingCount)
+    {
+        pendingCount = 0;
+        takenCount = 0;
+        return false;
+    }
+    addr = static_cast<address> (pendingAddrs[takenCount]);
+    byteWritten = static_cast<byte> (pendingBytes[takenCount]);
+    takenCount++;
+    return true;
+}
+
+bool MemoryGuard::beginTrappedWrite(const void *faultAddr)
+{
+    const byte *faultByte = static_cast<const byte *> (faultAddr);
+    if(trapPending || faultByte < addressSpace || faultByte >= addressSpace + 0x10000)
+    {
+        return false;
+    }
+    const address addr = static_cast<address> (faultByte - addressSpace);
+    const size page = addr / GUARD_PAGE_SIZE;
+    if(pageModes[page] == PAGE_UNGUARDED)
+    {
+        return false;
+    }
+
+    trapPending = true;
+    trappedAddr = addr;
+    trappedOriginal = addressSpace[addr];
+    return mprotect(addressSpace + page * GUARD_PAGE_SIZE, GUARD_PAGE_SIZE, PROT_READ | PROT_WRITE) == 0;
+}
+
+bool MemoryGuard::endTrappedWrite()
+{
+    if(!trapPending)
+    {
+        return false;
+    }
+    const size page = trappedAddr / GUARD_PAGE_SIZE;
+    const byte byteWritten = addressSpace[trappedAddr];
+    if(pageModes[page] == PAGE_DISCARD_WRITES)
+    {
+        addressSpace[trappedAddr] = trappedOriginal;
+    }
+    mprotect(addressSpace + page * GUARD_PAGE_SIZE, GUARD_PAGE_SIZE, PROT_READ);
+    trapPending = false;
+
+    const sig_atomic_t slot = pendingCount;
+    if(slot < static_cast<sig_atomic_t> (sizeof(pendingAddrs) / sizeof(pendingAddrs[0])))
+    {
+        pendingAddrs[slot] = trappedAddr;
+        pendingBytes[slot] = byteWritten;
+        pendingCount = slot + 1;
+    }
+    else
+    {
+        pendingDropped = 1;
+    }
+    return true;
+}
+
+static void onSegmentationFault(int, siginfo_t *info, void *context)
+{
+    if(activeGuard && activeGuard->beginTrappedWrite(info->si_addr))
+    {
+        static_cast<ucontext_t *> (context)->uc_mcontext.gregs[REG_EFL] |= TRAP_FLAG;
+        return;
+    }
+    // Not a guarded store, hand the fault back so it crashes as it normally would
+    sigaction(SIGSEGV, &previousSegvAction, NULL);
+}
+
+static void onTrap(int, siginfo_t *, void *context)
+{
+    if(activeGuard && activeGuard->endTrappedWrite())
+    {
+        static_cast<ucontext_t *> (context)->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+        return;
+    }
+    sigaction(SIGTRAP, &previousTrapAction, NULL);
+    raise(SIGTRAP);
+}
+
+#else
+
+MemoryGuard * MemoryGuard::create(byte *)
+{
+    Gahood::log("Guard pages are only supported on Linux x86 with the memfd address space");
+    return NULL;
+}
+
+MemoryGuard::~MemoryGuard()
+{
+}
+
+void MemoryGuard::protectPages(const address, const size, const bool)
+{
+}
+
+void MemoryGuard::reprotectPages(const address, const size)
+{
+}
+
+void MemoryGuard::unprotectPages(const address, const size)
+{
+}
+
+bool MemoryGuard::hasDroppedWrites() const
+{
+    return false;
+}
+
+bool MemoryGuard::takeTrappedWrite(address &, byte &)
+{
+    return false;
+}
+
+bool MemoryGuard::beginTrappedWrite(const void *)
+{
+    return false;
+}
+
+bool MemoryGuard::endTrappedWrite()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _GAHOOD_BOY_MEMORY_GUARD_HPP_
+#define _GAHOOD_BOY_MEMORY_GUARD_HPP_
+
+#include "util.hpp"
+
+#include <csignal>
+
+/*
+* Write protection for 4KiB pages of the memfd address space (Linux x86 only).
+* A store to a protected page faults, the page is briefly made writable and the
+* store is single stepped, then the written byte is queued for the owner to pick up
+* with takeTrappedWrite() once the store has returned, since nothing it does with it
+* is safe inside a signal handler. Pages protected with discardWrites (ROM) get their
+* original byte restored afterwards. Only the byte at the fault address is restored and
+* reported, so stores into guarded pages have to be single bytes, and wider copies
+* have to lift the guard with unprotectPages() around themselves.
+*/
+class MemoryGuard
+{
+public:
+    static MemoryGuard * create(byte *addressSpace);
+    ~MemoryGuard();
+
+    void protectPages(const address start, const size length, const bool discardWrites);
+    // Bank switches map pages back in writable, this protects the guarded ones among them again
+    void reprotectPages(const address start, const size length);
+    void unprotectPages(const address start, const size length);
+    // Oldest trapped write not taken yet, false once all of them were
+    bool takeTrappedWrite(address &addr, byte &byteWritten);
+    // True once a store trapped while the queue was full, the owner can't recover that write
+    bool hasDroppedWrites() const;
+
+    // Called from the SIGSEGV and SIGTRAP handlers
+    bool beginTrappedWrite(const void *faultAddr);
+    bool endTrappedWrite();
+
+private:
+    byte *addressSpace;
+    byte pageModes[16];
+
+    bool trapPending;
+    address trappedAddr;
+    byte trappedOriginal;
+
+    // Written by the SIGTRAP handler only, enough for every store one emulated instruction makes
+    volatile sig_atomic_t pendingAddrs[32];
+    volatile sig_atomic_t pendingBytes[32];
+    volatile sig_atomic_t pendingCount;
+    volatile sig_atomic_t pendingDropped;
+    sig_atomic_t takenCount;
+
+    MemoryGuard(byte *addressSpace);
+    MemoryGuard(const MemoryGuard &other);
+    MemoryGuard& operator=(const MemoryGuard &other);
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "memory_map.hpp"
+
+#ifdef GAHOOD_BOY_MEMFD
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const size GUEST_SPACE_SIZE = 0x10000;
+static const size ROM_BANK_SIZE = 0x4000;
+static const size RAM_BANK_SIZE = 0x2000;
+static const size VRAM_BANK_SIZE = 0x2000;
+static const long HOST_PAGE_SIZE = 0x1000;
+
+static bool writeFully(const int fileDescriptor, const byte *bytes, const size length, const size offset);
+
+MemoryMap * MemoryMap::create(const byte *rom, const size romSize, const size ramSize)
+{
+    if(sysconf(_SC_PAGESIZE) != HOST_PAGE_SIZE)
+    {
+        Gahood::log("Host page size is not 4KiB, using the flat memory buffer");
+        return NULL;
+    }
+
+    MemoryMap *memoryMap = new MemoryMap();
+    if(!memoryMap->open(romSize, ramSize) || !writeFully(memoryMap->fileDescriptor, rom, romSize, memoryMap->getRomOffset(0)))
+    {
+        Gahood::log("Failed to build the memfd address space, using the flat memory buffer");
+        delete memoryMap;
+        return NULL;
+    }
+    return memoryMap;
+}
+
+MemoryMap::MemoryMap()
+{
+    fileDescriptor = -1;
+    fileSize = 0;
+    addressSpace = NULL;
+    romBankCount = 0;
+    ramBankCount = 0;
+    romBank = 1;
+    ramBank = 0;
+    vramBank = 0;
+    romProtection = PROT_READ | PROT_WRITE;
+}
+
+MemoryMap::MemoryMap(const MemoryMap &other)
+{
+    fileDescriptor = -1;
+    fileSize = 0;
+    addressSpace = NULL;
+    romBankCount = 0;
+    ramBankCount = 0;
+    romBank = 1;
+    ramBank = 0;
+    vramBank = 0;
+    romProtection = PROT_READ | PROT_WRITE;
+    if(!open(other.romBankCount * ROM_BANK_SIZE, other.ramBankCount * RAM_BANK_SIZE))
+    {
+        Gahood::criticalError("Failed to build the memfd address space for the memory copy");
+    }
+
+    void *otherFile = mmap(NULL, other.fileSize, PROT_READ, MAP_SHARED, other.fileDescriptor, 0);
+    if(otherFile == MAP_FAILED)
+    {
+        Gahood::criticalError("Failed to map the memfd address space being copied");
+    }
+    const bool copied = writeFully(fileDescriptor, static_cast<const byte *> (otherFile), fileSize, 0);
+    munmap(otherFile, other.fileSize);
+    if(!copied)
+    {
+        Gahood::criticalError("Failed to copy the memfd address space");
+    }
+
+    mapRomBank(other.romBank);
+    mapRamBank(other.ramBank);
+    mapVramBank(other.vramBank);
+}
+
+MemoryMap::~MemoryMap()
+{
+    if(addressSpace)
+    {
+        munmap(addressSpace, GUEST_SPACE_SIZE);
+    }
+    if(fileDescriptor >= 0)
+    {
+        close(fileDescriptor);
+    }
+}
+
+byte * MemoryMap::getAddressSpace() const
+{
+    return addressSpace;
+}
+
+void MemoryMap::mapRomBank(const size bank)
+{
+    const size bankToMap = bank % romBankCount;
+    if(bankToMap == romBank)
+    {
+        return;
+    }
+    if(!mapPages(0x4000, ROM_BANK_SIZE, getRomOffset(bankToMap), romProtection))
+    {
+        Gahood::criticalError("Failed to map ROM bank %d", static_cast<int> (bankToMap));
+    }
+    romBank = bankToMap;
+}
+
+void MemoryMap::mapRamBank(const size bank)
+{
+    if(ramBankCount == 0)
+    {
+        return;
+    }
+    const size bankToMap = bank % ramBankCount;
+    if(bankToMap == ramBank)
+    {
+        return;
+    }
+    if(!mapPages(0xA000, RAM_BANK_SIZE, getRamOffset(bankToMap), PROT_READ | PROT_WRITE))
+    {
+        Gahood::criticalError("Failed to map cartridge RAM bank %d", static_cast<int> (bankToMap));
+    }
+    ramBank = bankToMap;
+}
+
+void MemoryMap::mapVramBank(const size bank)
+{
+    const size bankToMap = bank & 0x01;
+    if(bankToMap == vramBank)
+    {
+        return;
+    }
+    if(!mapPages(0x8000, VRAM_BANK_SIZE, getVramOffset(bankToMap), PROT_READ | PROT_WRITE))
+    {
+        Gahood::criticalError("Failed to map VRAM bank %d", static_cast<int> (bankToMap));
+    }
+    vramBank = bankToMap;
+}
+
+void MemoryMap::setRomReadOnly()
+{
+    romProtection = PROT_READ;
+    if(mprotect(addressSpace, 2 * ROM_BANK_SIZE, romProtection) < 0)
+    {
+        Gahood::criticalError("Failed to write protect the ROM banks");
+    }
+}
+
+bool MemoryMap::open(const size romSize, const size ramSize)
+{
+    romBankCount = (romSize + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE;
+    if(romBankCount < 2)
+    {
+        romBankCount = 2;
+    }
+    ramBankCount = (ramSize + RAM_BANK_SIZE - 1) / RAM_BANK_SIZE;
+    fileSize = GUEST_SPACE_SIZE + romBankCount * ROM_BANK_SIZE + ramBankCount * RAM_BANK_SIZE + VRAM_BANK_SIZE;
+
+    fileDescriptor = memfd_create("GahoodBoy", MFD_CLOEXEC);
+    if(fileDescriptor < 0 || ftruncate(fileDescriptor, static_cast<off_t> (fileSize)) < 0)
+    {
+        return false;
+    }
+
+    // Reserve the whole guest range first so the fixed mappings below never clobber anything else
+    void *reserved = mmap(NULL, GUEST_SPACE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(reserved == MAP_FAILED)
+    {
+        return false;
+    }
+    addressSpace = static_cast<byte *> (reserved);
+
+    const int readWrite = PROT_READ | PROT_WRITE;
+    return mapPages(0x0000, ROM_BANK_SIZE, getRomOffset(0), romProtection)
+        && mapPages(0x4000, ROM_BANK_SIZE, getRomOffset(1), romProtection)
+        && mapPages(0x8000, 0x2000, 0x8000, readWrite)
+        && mapPages(0xA000, 0x2000, ramBankCount > 0 ? getRamOffset(0) : 0xA000, readWrite)
+        && mapPages(0xC000, 0x2000, 0xC000, readWrite)
+        && mapPages(0xE000, 0x1000, 0xC000, readWrite) // Echo RAM, aliases the first WRAM page
+        && mapPages(0xF000, 0x1000, 0xF000, readWrite); // Shared by the rest of echo RAM, OAM, IO and HRAM
+}
+
+bool MemoryMap::mapPages(const address guestAddr, const size length, const size fileOffset, const int protection)
+{
+    void *mapped = mmap(addressSpace + guestAddr, length, protection, MAP_SHARED | MAP_FIXED,
+        fileDescriptor, static_cast<off_t> (fileOffset));
+    return mapped != MAP_FAILED;
+}
+
+size MemoryMap::getRomOffset(const size bank) const
+{
+    return GUEST_SPACE_SIZE + bank * ROM_BANK_SIZE;
+}
+
+size MemoryMap::getRamOffset(const size bank) const
+{
+    return GUEST_SPACE_SIZE + romBankCount * ROM_BANK_SIZE + bank * RAM_BANK_SIZE;
+}
+
+size MemoryMap::getVramOffset(const size bank) const
+{
+    // Bank 0 is the guest VRAM range itself, bank 1 lives after the cartridge RAM
+    return bank == 0 ? 0x8000 : getRamOffset(ramBankCount);
+}
+
+static bool writeFully(const int fileDescriptor, const byte *bytes, const size length, const size offset)
+{
+    size written = 0;
+    while(written < length)
+    {
+        const ssize_t result = pwrite(fileDescriptor, bytes + written, length - written, static_cast<off_t> (offset + written));
+        if(result <= 0)
+        {
+            return false;
+        }
+        written += static_cast<size> (result);
+    }
+    return true;
+}
+
+#else
+
+// Without memfd support the flat memory buffer is always used
+MemoryMap * MemoryMap::create(const byte *, const size, const size)
+{
+    return NULL;
+}
+
+MemoryMap::MemoryMap(const MemoryMap &)
+{
+}
+
+MemoryMap::~MemoryMap()
+{
+}
+
+byte * MemoryMap::getAddressSpace() const
+{
+    return NULL;
+}
+
+void MemoryMap::mapRomBank(const size)
+{
+}
+
+void MemoryMap::mapRamBank(const size)
+{
+}
+
+void MemoryMap::mapVramBank(const size)
+{
+}
+
+void MemoryMap::setRomReadOnly()
+{
+}
+
+#endif
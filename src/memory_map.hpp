@@ -0,0 +1,47 @@
+#ifndef _GAHOOD_BOY_MEMORY_MAP_HPP_
+#define _GAHOOD_BOY_MEMORY_MAP_HPP_
+
+#include "util.hpp"
+
+/*
+* Linux only guest address space built out of memfd backed pages.
+* Guest address X of the unbanked regions lives at file offset X, followed by the
+* ROM banks, the cartridge RAM banks and the second CGB VRAM bank. Echo RAM at 0xE000-0xEFFF is a second
+* mapping of the WRAM page at 0xC000 and bank switches re-map already loaded pages,
+* so mirroring and banking cost nothing on the read and write paths.
+*/
+class MemoryMap
+{
+public:
+    static MemoryMap * create(const byte *rom, const size romSize, const size ramSize);
+    MemoryMap(const MemoryMap &other);
+    ~MemoryMap();
+
+    byte * getAddressSpace() const;
+    void mapRomBank(const size bank);
+    void mapRamBank(const size bank);
+    void mapVramBank(const size bank);
+    void setRomReadOnly();
+
+private:
+    int fileDescriptor;
+    size fileSize;
+    byte *addressSpace;
+    size romBankCount;
+    size ramBankCount;
+    size romBank;
+    size ramBank;
+    size vramBank;
+    int romProtection;
+
+    MemoryMap();
+    MemoryMap& operator=(const MemoryMap &other);
+
+    bool open(const size romSize, const size ramSize);
+    bool mapPages(const address guestAddr, const size length, const size fileOffset, const int protection);
+    size getRomOffset(const size bank) const;
+    size getRamOffset(const size bank) const;
+    size getVramOffset(const size bank) const;
+};
+
+#endif
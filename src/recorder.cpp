@@ -0,0 +1,283 @@
+#include "recorder.hpp"
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const unsigned int RING_SLOTS = 32;
+static const size STAGING_SIZE = 4 * 1024 * 1024;
+static const size STAGING_ALIGNMENT = 4096; // O_DIRECT wants block aligned buffers, offsets and lengths
+static const size PIXEL_COUNT = 160 * 144;
+static const char Y4M_HEADER[] = "YUV4MPEG2 W160 H144 F4194304:70224 Ip A1:1 C444\n";
+static const char Y4M_FRAME_HEADER[] = "FRAME\n";
+
+Recorder::Recorder(const char *filePath, const RecordFormat format, const bool directIo, const bool dropWhenBehind)
+{
+	this->format = format;
+	this->dropWhenBehind = dropWhenBehind;
+	droppedFrames = 0;
+	fullWaits = 0;
+	stagingUsed = 0;
+	bytesWritten = 0;
+	file = NULL;
+	directFile = -1;
+
+	slots = (Frame *) malloc(RING_SLOTS * sizeof(Frame));
+	converted = (byte *) malloc(PIXEL_COUNT * 3);
+	stagingMemory = (byte *) malloc(STAGING_SIZE + STAGING_ALIGNMENT);
+	if (!slots || !converted || !stagingMemory)
+	{
+		Gahood::criticalError("Failed to allocate the recording buffers");
+	}
+	staging = stagingMemory + (STAGING_ALIGNMENT - reinterpret_cast<size> (stagingMemory) % STAGING_ALIGNMENT) % STAGING_ALIGNMENT;
+
+	if (directIo)
+	{
+#ifdef __linux__
+		directFile = open(filePath, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+		if (directFile < 0)
+		{
+			Gahood::log("The file system does not take O_DIRECT, recording through the page cache");
+		}
+#else
+		Gahood::log("O_DIRECT recording is only supported on Linux, recording through the page cache");
+#endif
+	}
+	if (directFile < 0)
+	{
+		file = SDL_RWFromFile(filePath, "wb");
+		if (!file)
+		{
+			Gahood::criticalSdlError("Failed to open the recording file %s", filePath);
+		}
+	}
+	if (format == RECORD_Y4M)
+	{
+		append(reinterpret_cast<const byte *> (Y4M_HEADER), sizeof(Y4M_HEADER) - 1);
+	}
+
+	SDL_AtomicSet(&head, 0);
+	SDL_AtomicSet(&tail, 0);
+	SDL_AtomicSet(&running, 1);
+	framesReady = SDL_CreateSemaphore(0);
+	slotsFreed = SDL_CreateSemaphore(0);
+	if (!framesReady || !slotsFreed)
+	{
+		Gahood::criticalSdlError("Failed to create the recording semaphores");
+	}
+	writerThread = SDL_CreateThread(runWriter, "GahoodBoyRecorder", this);
+	if (!writerThread)
+	{
+		Gahood::criticalSdlError("Failed to start the recording thread");
+	}
+}
+
+Recorder::~Recorder()
+{
+	// The writer drains every frame still in the ring before it exits
+	SDL_AtomicSet(&running, 0);
+	SDL_SemPost(framesReady);
+	SDL_WaitThread(writerThread, NULL);
+	SDL_DestroySemaphore(slotsFreed);
+	SDL_DestroySemaphore(framesReady);
+
+#ifdef __linux__
+	if (directFile >= 0)
+	{
+		close(directFile);
+	}
+#endif
+	if (file)
+	{
+		SDL_RWclose(file);
+	}
+	Gahood::log("Recorded %d frames (%lu bytes), dropped %d, waited on the disk %d times",
+		SDL_AtomicGet(&tail), bytesWritten, droppedFrames, fullWaits);
+
+	free(stagingMemory);
+	free(converted);
+	free(slots);
+}
+
+void Recorder::record(const Frame &frame)
+{
+	const int produced = SDL_AtomicGet(&head);
+	if (static_cast<unsigned int> (produced - SDL_AtomicGet(&tail)) >= RING_SLOTS)
+	{
+		// The writer fell behind, either lose the frame or hold emulation up until a slot frees
+		if (dropWhenBehind)
+		{
+			droppedFrames++;
+			return;
+		}
+		fullWaits++;
+		while (static_cast<unsigned int> (produced - SDL_AtomicGet(&tail)) >= RING_SLOTS)
+		{
+			SDL_SemWaitTimeout(slotsFreed, 10);
+		}
+	}
+	memcpy(&slots[static_cast<unsigned int> (produced) % RING_SLOTS], &frame, sizeof(Frame));
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&head, produced + 1);
+	SDL_SemPost(framesReady);
+}
+
+int Recorder::runWriter(void *recorder)
+{
+	static_cast<Recorder *> (recorder)->writeLoop();
+	return 0;
+}
+
+void Recorder::writeLoop()
+{
+	int consumed = SDL_AtomicGet(&tail);
+	while (true)
+	{
+		// Checked before head, so once stopping is seen every recorded frame is visible
+		const bool stopping = !SDL_AtomicGet(&running);
+		if (consumed != SDL_AtomicGet(&head))
+		{
+			SDL_MemoryBarrierAcquire();
+			convertFrame(slots[static_cast<unsigned int> (consumed) % RING_SLOTS]);
+			consumed++;
+			SDL_AtomicSet(&tail, consumed);
+			SDL_SemPost(slotsFreed);
+		}
+		else if (stopping)
+		{
+			break;
+		}
+		else
+		{
+			SDL_SemWaitTimeout(framesReady, 100);
+		}
+	}
+	flush(true);
+}
+
+void Recorder::convertFrame(const Frame &frame)
+{
+	// Only 64 distinct pixel values exist, so each is converted once and pixels become lookups
+	byte converted0[64], converted1[64], converted2[64];
+	for (byte value = 0; value < 64; value++)
+	{
+		const Uint32 color = frame.colors[value]; // RGBA8888, red in the most significant byte
+		const int red = (color >> 24) & 0xFF;
+		const int green = (color >> 16) & 0xFF;
+		const int blue = (color >> 8) & 0xFF;
+		if (format == RECORD_RAW)
+		{
+			converted0[value] = static_cast<byte> (red);
+			converted1[value] = static_cast<byte> (green);
+			converted2[value] = static_cast<byte> (blue);
+		}
+		else // BT.601 studio range Y, Cb and Cr
+		{
+			converted0[value] = static_cast<byte> (((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16);
+			converted1[value] = static_cast<byte> (((-38 * red - 74 * green + 112 * blue + 128) >> 8) + 128);
+			converted2[value] = static_cast<byte> (((112 * red - 94 * green - 18 * blue + 128) >> 8) + 128);
+		}
+	}
+
+	if (format == RECORD_RAW)
+	{
+		for (size pixel = 0; pixel < PIXEL_COUNT; pixel++)
+		{
+			const byte value = frame.pixels[pixel] & 0x3F;
+			converted[pixel * 3] = converted0[value];
+			converted[pixel * 3 + 1] = converted1[value];
+			converted[pixel * 3 + 2] = converted2[value];
+		}
+	}
+	else
+	{
+		// Y4M stores one full plane after the other
+		for (size pixel = 0; pixel < PIXEL_COUNT; pixel++)
+		{
+			const byte value = frame.pixels[pixel] & 0x3F;
+			converted[pixel] = converted0[value];
+			converted[PIXEL_COUNT + pixel] = converted1[value];
+			converted[PIXEL_COUNT * 2 + pixel] = converted2[value];
+		}
+		append(reinterpret_cast<const byte *> (Y4M_FRAME_HEADER), sizeof(Y4M_FRAME_HEADER) - 1);
+	}
+	append(converted, PIXEL_COUNT * 3);
+}
+
+void Recorder::append(const byte *bytes, const size length)
+{
+	size appended = 0;
+	while (appended < length)
+	{
+		size chunk = STAGING_SIZE - stagingUsed;
+		if (chunk > length - appended)
+		{
+			chunk = length - appended;
+		}
+		memcpy(staging + stagingUsed, bytes + appended, chunk);
+		stagingUsed += chunk;
+		appended += chunk;
+		if (stagingUsed == STAGING_SIZE)
+		{
+			flush(false);
+		}
+	}
+}
+
+void Recorder::flush(const bool final)
+{
+	if (stagingUsed == 0)
+	{
+		return;
+	}
+#ifdef __linux__
+	if (directFile >= 0)
+	{
+		if (final && stagingUsed % STAGING_ALIGNMENT != 0)
+		{
+			// O_DIRECT only takes whole blocks, the tail of the file goes through the page cache
+			fcntl(directFile, F_SETFL, fcntl(directFile, F_GETFL) & ~O_DIRECT);
+		}
+		size written = 0;
+		while (written < stagingUsed)
+		{
+			const ssize_t result = write(directFile, staging + written, stagingUsed - written);
+			if (result <= 0)
+			{
+				Gahood::criticalError("Failed to write to the recording file");
+			}
+			written += static_cast<size> (result);
+		}
+	}
+#endif
+	if (file && SDL_RWwrite(file, staging, 1, stagingUsed) != stagingUsed)
+	{
+		Gahood::criticalSdlError("Failed to write to the recording file");
+	}
+	bytesWritten += stagingUsed;
+	stagingUsed = 0;
+}
+
+RecordingScreen::RecordingScreen(Screen &screen, const char *filePath, const RecordFormat format, const bool directIo, const bool dropWhenBehind)
+	: screen(screen), recorder(filePath, format, directIo, dropWhenBehind)
+{
+}
+
+Frame * RecordingScreen::getBackFrame()
+{
+	return screen.getBackFrame();
+}
+
+void RecordingScreen::publishFrame()
+{
+	// The back frame still belongs to the thread that rendered it (the render thread with -t) until it is published
+	recorder.record(*screen.getBackFrame());
+	screen.publishFrame();
+}
+
+void RecordingScreen::pumpEvents()
+{
+	screen.pumpEvents();
+}
@@ -0,0 +1,74 @@
+#ifndef _GAHOOD_BOY_RECORDER_HPP_
+#define _GAHOOD_BOY_RECORDER_HPP_
+
+#include "screen.hpp"
+
+enum RecordFormat
+{
+	RECORD_RAW, // Bare 160x144 RGB24 frames back to back
+	RECORD_Y4M  // YUV4MPEG2, 4:4:4 BT.601 at the exact 4194304/70224 frame rate
+};
+
+/*
+* Streams frames to disk off the thread that renders them.
+* record() copies the frame into a single producer, single consumer ring and a writer
+* thread converts it and writes it out in large aligned chunks, optionally with O_DIRECT
+* on Linux. When the ring is full record() waits for the writer so every frame is kept,
+* or with dropWhenBehind drops the frame and counts it instead.
+*/
+class Recorder
+{
+public:
+	Recorder(const char *filePath, const RecordFormat format, const bool directIo, const bool dropWhenBehind);
+	~Recorder();
+
+	void record(const Frame &frame);
+
+private:
+	RecordFormat format;
+	bool dropWhenBehind;
+	Frame *slots;
+	SDL_atomic_t head; // Frames handed over by the rendering thread
+	SDL_atomic_t tail; // Frames consumed by the writer thread
+	SDL_atomic_t running;
+	SDL_sem *framesReady;
+	SDL_sem *slotsFreed;
+	SDL_Thread *writerThread;
+	int droppedFrames;
+	int fullWaits;
+
+	// Only touched by the writer thread once it runs
+	byte *converted;
+	byte *stagingMemory;
+	byte *staging;
+	size stagingUsed;
+	SDL_RWops *file;
+	int directFile;
+	size bytesWritten;
+
+	Recorder(const Recorder &other);
+	Recorder& operator=(const Recorder &other);
+
+	static int runWriter(void *recorder);
+	void writeLoop();
+	void convertFrame(const Frame &frame);
+	void append(const byte *bytes, const size length);
+	void flush(const bool final);
+};
+
+// Screen that records every published frame before passing it on to another screen
+class RecordingScreen : public Screen
+{
+public:
+	RecordingScreen(Screen &screen, const char *filePath, const RecordFormat format, const bool directIo, const bool dropWhenBehind);
+
+	Frame * getBackFrame();
+	void publishFrame();
+	void pumpEvents();
+
+private:
+	Screen &screen;
+	Recorder recorder;
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include "render_queue.hpp"
+#include <cstring>
+
+static const unsigned int QUEUE_SIZE = 1 << 16; // Comfortably more than the writes and lines of a frame
+static const unsigned int RELEASE_INTERVAL = 1024; // Events the worker replays before handing their slots back
+static const size BLOCK_SIZE = 0x10; // Block writes are counted in VRAM DMA blocks
+
+RenderQueue::RenderQueue(LineRenderer &renderer, Screen &screen, const bool threaded, const bool timed) : renderer(renderer), screen(screen)
+{
+	this->timed = timed;
+	SDL_AtomicSet(&renderCost, 0);
+	events = NULL;
+	head = 0;
+	freeUntil = QUEUE_SIZE;
+	fullWaits = 0;
+	eventsReady = NULL;
+	spaceReady = NULL;
+	workerThread = NULL;
+	SDL_AtomicSet(&published, 0);
+	SDL_AtomicSet(&consumed, 0);
+	SDL_AtomicSet(&producerWaiting, 0);
+	SDL_AtomicSet(&workerWaiting, 0);
+	if (!threaded)
+	{
+		return;
+	}
+
+	events = (Event *) malloc(QUEUE_SIZE * sizeof(Event));
+	if (!events)
+	{
+		Gahood::criticalError("Failed to allocate the render queue");
+	}
+	eventsReady = SDL_CreateSemaphore(0);
+	spaceReady = SDL_CreateSemaphore(0);
+	if (!eventsReady || !spaceReady)
+	{
+		Gahood::criticalSdlError("Failed to create the render queue semaphores");
+	}
+	workerThread = SDL_CreateThread(runWorker, "GahoodBoyRenderer", this);
+	if (!workerThread)
+	{
+		Gahood::criticalSdlError("Failed to start the render thread");
+	}
+}
+
+RenderQueue::~RenderQueue()
+{
+	if (!events)
+	{
+		return;
+	}
+
+	// The worker replays everything logged so far before it sees the stop
+	push(EVENT_STOP, 0x0000, 0x00);
+	publish();
+	SDL_WaitThread(workerThread, NULL);
+	SDL_DestroySemaphore(spaceReady);
+	SDL_DestroySemaphore(eventsReady);
+	free(events);
+	if (fullWaits > 0)
+	{
+		Gahood::log("Emulation waited on the render thread %d times", fullWaits);
+	}
+}
+
+void RenderQueue::write(const address addr, const byte byteWritten)
+{
+	push(EVENT_WRITE, addr, byteWritten);
+}
+
+void RenderQueue::writeBlock(const address addr, const byte *bytes, const size length)
+{
+	if (!events)
+	{
+		renderer.writeBlock(addr, bytes, length);
+		return;
+	}
+
+	push(EVENT_WRITE_BLOCK, addr, static_cast<byte> (length / BLOCK_SIZE));
+	for (size offset = 0; offset < length; offset += sizeof(Event))
+	{
+		Event payload;
+		memcpy(&payload, bytes + offset, sizeof(Event));
+		append(payload);
+	}
+}
+
+void RenderQueue::beginFrame()
+{
+	push(EVENT_BEGIN_FRAME, 0x0000, 0x00);
+}
+
+void RenderQueue::renderLine(const byte line)
+{
+	push(EVENT_RENDER_LINE, 0x0000, line);
+	if (events)
+	{
+		publish();
+	}
+}
+
+void RenderQueue::present()
+{
+	push(EVENT_PRESENT, 0x0000, 0x00);
+	if (events)
+	{
+		publish();
+	}
+}
+
+microseconds RenderQueue::takeRenderCost()
+{
+	return static_cast<microseconds> (SDL_AtomicSet(&renderCost, 0));
+}
+
+void RenderQueue::push(const byte type, const address addr, const byte value)
+{
+	Event event;
+	event.addr = addr;
+	event.value = value;
+	event.type = type;
+	if (!events)
+	{
+		run(event);
+		return;
+	}
+	append(event);
+}
+
+void RenderQueue::append(const Event &event)
+{
+	if (head == freeUntil)
+	{
+		waitForSpace();
+	}
+	events[head % QUEUE_SIZE] = event;
+	head++;
+}
+
+void RenderQueue::publish()
+{
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&published, static_cast<int> (head));
+	if (SDL_AtomicGet(&workerWaiting))
+	{
+		SDL_SemPost(eventsReady);
+	}
+}
+
+void RenderQueue::waitForSpace()
+{
+	freeUntil = static_cast<unsigned int> (SDL_AtomicGet(&consumed)) + QUEUE_SIZE;
+	if (head != freeUntil)
+	{
+		return;
+	}
+
+	// The worker is a whole ring behind, everything logged so far has to be handed over for it to catch up
+	fullWaits++;
+	publish();
+	SDL_AtomicSet(&producerWaiting, 1);
+	while ((freeUntil = static_cast<unsigned int> (SDL_AtomicGet(&consumed)) + QUEUE_SIZE) == head)
+	{
+		SDL_SemWaitTimeout(spaceReady, 10);
+	}
+	SDL_AtomicSet(&producerWaiting, 0);
+}
+
+void RenderQueue::run(const Event &event)
+{
+	if (timed && (event.type == EVENT_RENDER_LINE || event.type == EVENT_PRESENT))
+	{
+		const microseconds start = Gahood::getCurrentMicroseconds();
+		runUntimed(event);
+		SDL_AtomicAdd(&renderCost, static_cast<int> (Gahood::getCurrentMicroseconds() - start));
+		return;
+	}
+	runUntimed(event);
+}
+
+void RenderQueue::runUntimed(const Event &event)
+{
+	switch (event.type)
+	{
+	case EVENT_WRITE:
+		renderer.write(event.addr, event.value);
+		break;
+	case EVENT_BEGIN_FRAME:
+		renderer.beginFrame();
+		break;
+	case EVENT_RENDER_LINE:
+		renderer.renderLine(event.value);
+		break;
+	case EVENT_PRESENT:
+		renderer.present(screen);
+		break;
+	default:
+		break;
+	}
+}
+
+int RenderQueue::runWorker(void *queue)
+{
+	static_cast<RenderQueue *> (queue)->replayLoop();
+	return 0;
+}
+
+void RenderQueue::replayLoop()
+{
+	unsigned int position = 0;
+	unsigned int released = 0;
+	while (true)
+	{
+		const unsigned int end = static_cast<unsigned int> (SDL_AtomicGet(&published));
+		SDL_MemoryBarrierAcquire();
+		while (position != end)
+		{
+			const Event &event = events[position % QUEUE_SIZE];
+			unsigned int eventCount = 1;
+			if (event.type == EVENT_STOP)
+			{
+				return;
+			}
+			else if (event.type == EVENT_WRITE_BLOCK)
+			{
+				eventCount += static_cast<unsigned int> (event.value * BLOCK_SIZE / sizeof(Event));
+				if (end - position < eventCount)
+				{
+					break; // Published while the CPU thread waited for space halfway through the bytes
+				}
+				replayBlock(position);
+			}
+			else
+			{
+				run(event);
+			}
+			position += eventCount;
+			if (position - released >= RELEASE_INTERVAL)
+			{
+				release(position);
+				released = position;
+			}
+		}
+		if (position != released)
+		{
+			release(position);
+			released = position;
+		}
+		// Announce the sleep before the last look at published, so a publish after it is sure to post
+		SDL_AtomicSet(&workerWaiting, 1);
+		if (static_cast<unsigned int> (SDL_AtomicGet(&published)) == end)
+		{
+			SDL_SemWaitTimeout(eventsReady, 100);
+		}
+		SDL_AtomicSet(&workerWaiting, 0);
+	}
+}
+
+void RenderQueue::replayBlock(const unsigned int position)
+{
+	const Event &header = events[position % QUEUE_SIZE];
+	const size length = header.value * BLOCK_SIZE;
+	for (size offset = 0; offset < length; offset += sizeof(Event))
+	{
+		// The bytes may wrap around the end of the ring, so they are gathered first
+		const unsigned int payload = position + 1 + static_cast<unsigned int> (offset / sizeof(Event));
+		memcpy(blockBytes + offset, &events[payload % QUEUE_SIZE], sizeof(Event));
+	}
+	renderer.writeBlock(header.addr, blockBytes, length);
+}
+
+void RenderQueue::release(const unsigned int position)
+{
+	SDL_AtomicSet(&consumed, static_cast<int> (position));
+	if (SDL_AtomicGet(&producerWaiting))
+	{
+		SDL_SemPost(spaceReady);
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef _GAHOOD_BOY_RENDER_QUEUE_HPP_
+#define _GAHOOD_BOY_RENDER_QUEUE_HPP_
+
+#include "line_renderer.hpp"
+
+/*
+* Feeds a LineRenderer a log of VRAM, OAM and LCD register writes with frame starts,
+* line renders and presents in between, so each line sees exactly the writes made
+* before it. Without a worker every event runs right away. With one, the CPU thread
+* only appends to a single producer, single consumer ring and the worker replays it
+* a few lines behind, producing the same frames since the order never changes.
+* The CPU thread waits instead of dropping events when the ring is full. Block writes
+* travel as a header event followed by the bytes themselves, four to an event.
+* When timed, the time spent rendering lines and presenting is added up on whichever
+* thread does it, for frameskip to collect with takeRenderCost().
+*/
+class RenderQueue
+{
+public:
+	RenderQueue(LineRenderer &renderer, Screen &screen, const bool threaded, const bool timed);
+	~RenderQueue();
+
+	void write(const address addr, const byte byteWritten);
+	// VRAM DMA runs, the length is a multiple of 16 up to 0x800
+	void writeBlock(const address addr, const byte *bytes, const size length);
+	void beginFrame();
+	void renderLine(const byte line);
+	void present();
+	// Render and present time spent since the last call
+	microseconds takeRenderCost();
+
+private:
+	enum EventType
+	{
+		EVENT_WRITE,
+		EVENT_WRITE_BLOCK,
+		EVENT_BEGIN_FRAME,
+		EVENT_RENDER_LINE,
+		EVENT_PRESENT,
+		EVENT_STOP
+	};
+
+	struct Event
+	{
+		address addr;
+		byte value; // Byte written, 16 byte blocks written, or the line to render
+		byte type;
+	};
+
+	LineRenderer &renderer;
+	Screen &screen;
+	Event *events; // NULL without a worker
+	unsigned int head; // Events appended by the CPU thread, published up to here in published
+	unsigned int freeUntil; // head can grow up to this before the worker has to be checked again
+	SDL_atomic_t published;
+	SDL_atomic_t consumed; // Events the worker is done with, their slots can be reused
+	SDL_atomic_t producerWaiting;
+	SDL_atomic_t workerWaiting; // Set while the worker is about to sleep on eventsReady, publish() only posts then
+	bool timed;
+	SDL_atomic_t renderCost;
+	SDL_sem *eventsReady;
+	SDL_sem *spaceReady;
+	SDL_Thread *workerThread;
+	int fullWaits;
+	byte blockBytes[0x800]; // Block write payload gathered out of the ring by the worker
+
+	RenderQueue(const RenderQueue &other);
+	RenderQueue& operator=(const RenderQueue &other);
+
+	void push(const byte type, const address addr, const byte value);
+	void append(const Event &event);
+	void publish();
+	void waitForSpace();
+	void run(const Event &event);
+	void runUntimed(const Event &event);
+	static int runWorker(void *queue);
+	void replayLoop();
+	void replayBlock(const unsigned int position);
+	void release(const unsigned int position);
+};
+
+#endif
@@ -0,0 +1,461 @@
+#include "scaler.hpp"
+#include "simd.hpp"
+
+#include <cstring>
+
+static const size SOURCE_WIDTH = 160;
+static const size SOURCE_HEIGHT = 144;
+static const size PADDED_WIDTH = SOURCE_WIDTH + 2;
+
+// Smoothing kernels get padded rows, so x - 1 and x + 1 are always readable
+typedef void (*NearestRowKernel)(const Uint32 *source, Uint32 *destination, const size width, const byte factor);
+typedef void (*Scale2xRowKernel)(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, const size width);
+typedef void (*Scale3xRowKernel)(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, Uint32 *out2, const size width);
+
+static void selectNearestRow(const Uint32 *source, Uint32 *destination, const size width, const byte factor);
+static void selectScale2xRow(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, const size width);
+static void selectScale3xRow(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, Uint32 *out2, const size width);
+
+static NearestRowKernel nearestRowKernel = selectNearestRow;
+static Scale2xRowKernel scale2xRowKernel = selectScale2xRow;
+static Scale3xRowKernel scale3xRowKernel = selectScale3xRow;
+
+const byte Scaler::MAX_FACTOR;
+
+Scaler::Scaler(const ScaleFilter filter, const byte factor)
+{
+    this->filter = filter;
+    switch(filter)
+    {
+    case SCALE_2X:
+        this->factor = 2;
+        break;
+    case SCALE_3X:
+        this->factor = 3;
+        break;
+    default:
+        this->factor = factor < 1 ? 1 : (factor > MAX_FACTOR ? MAX_FACTOR : factor);
+        break;
+    }
+
+    padded = (Uint32 *) malloc(PADDED_WIDTH * (SOURCE_HEIGHT + 2) * sizeof(Uint32));
+    scaled = (Uint32 *) malloc(getWidth() * getHeight() * sizeof(Uint32));
+    if(!padded || !scaled)
+    {
+        Gahood::criticalError("Failed to allocate the scaler buffers");
+    }
+}
+
+Scaler::~Scaler()
+{
+    free(scaled);
+    free(padded);
+}
+
+byte Scaler::getFactor() const
+{
+    return factor;
+}
+
+size Scaler::getWidth() const
+{
+    return SOURCE_WIDTH * factor;
+}
+
+size Scaler::getHeight() const
+{
+    return SOURCE_HEIGHT * factor;
+}
+
+const Uint32 * Scaler::scale(const Uint32 *pixels)
+{
+    const size width = getWidth();
+    if(filter == SCALE_NEAREST)
+    {
+        if(factor == 1)
+        {
+            return pixels;
+        }
+        for(size y = 0; y < SOURCE_HEIGHT; y++)
+        {
+            // Expand the row once, the remaining output rows are plain copies of it
+            Uint32 *firstRow = scaled + y * factor * width;
+            nearestRowKernel(pixels + y * SOURCE_WIDTH, firstRow, SOURCE_WIDTH, factor);
+            for(byte repeat = 1; repeat < factor; repeat++)
+            {
+                memcpy(firstRow + repeat * width, firstRow, width * sizeof(Uint32));
+            }
+        }
+        return scaled;
+    }
+
+    pad(pixels);
+    for(size y = 0; y < SOURCE_HEIGHT; y++)
+    {
+        const Uint32 *row = padded + (y + 1) * PADDED_WIDTH + 1;
+        Uint32 *out = scaled + y * factor * width;
+        if(filter == SCALE_2X)
+        {
+            scale2xRowKernel(row - PADDED_WIDTH, row, row + PADDED_WIDTH, out, out + width, SOURCE_WIDTH);
+        }
+        else
+        {
+            scale3xRowKernel(row - PADDED_WIDTH, row, row + PADDED_WIDTH, out, out + width, out + 2 * width, SOURCE_WIDTH);
+        }
+    }
+    return scaled;
+}
+
+void Scaler::resetKernels()
+{
+    nearestRowKernel = selectNearestRow;
+    scale2xRowKernel = selectScale2xRow;
+    scale3xRowKernel = selectScale3xRow;
+}
+
+void Scaler::pad(const Uint32 *pixels)
+{
+    for(size y = 0; y < SOURCE_HEIGHT; y++)
+    {
+        Uint32 *row = padded + (y + 1) * PADDED_WIDTH;
+        memcpy(row + 1, pixels + y * SOURCE_WIDTH, SOURCE_WIDTH * sizeof(Uint32));
+        row[0] = row[1];
+        row[SOURCE_WIDTH + 1] = row[SOURCE_WIDTH];
+    }
+    memcpy(padded, padded + PADDED_WIDTH, PADDED_WIDTH * sizeof(Uint32));
+    memcpy(padded + (SOURCE_HEIGHT + 1) * PADDED_WIDTH, padded + SOURCE_HEIGHT * PADDED_WIDTH, PADDED_WIDTH * sizeof(Uint32));
+}
+
+static void nearestRowScalar(const Uint32 *source, Uint32 *destination, const size width, const byte factor)
+{
+    for(size x = 0; x < width; x++)
+    {
+        for(byte repeat = 0; repeat < factor; repeat++)
+        {
+            *destination++ = source[x];
+        }
+    }
+}
+
+static void scale2xRowScalar(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, const size width)
+{
+    for(size x = 0; x < width; x++)
+    {
+        const Uint32 b = above[x], d = row[x - 1], e = row[x], f = row[x + 1], h = below[x];
+        if(b != h && d != f)
+        {
+            out0[x * 2] = d == b ? d : e;
+            out0[x * 2 + 1] = b == f ? f : e;
+            out1[x * 2] = d == h ? d : e;
+            out1[x * 2 + 1] = h == f ? f : e;
+        }
+        else
+        {
+            out0[x * 2] = out0[x * 2 + 1] = out1[x * 2] = out1[x * 2 + 1] = e;
+        }
+    }
+}
+
+static void scale3xRowScalar(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, Uint32 *out2, const size width)
+{
+    for(size x = 0; x < width; x++)
+    {
+        const Uint32 a = above[x - 1], b = above[x], c = above[x + 1];
+        const Uint32 d = row[x - 1], e = row[x], f = row[x + 1];
+        const Uint32 g = below[x - 1], h = below[x], i = below[x + 1];
+        Uint32 *e012 = out0 + x * 3;
+        Uint32 *e345 = out1 + x * 3;
+        Uint32 *e678 = out2 + x * 3;
+        if(b != h && d != f)
+        {
+            e012[0] = d == b ? d : e;
+            e012[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+            e012[2] = b == f ? f : e;
+            e345[0] = (d == b && e != g) || (d == h && e != a) ? d : e;
+            e345[1] = e;
+            e345[2] = (b == f && e != i) || (h == f && e != c) ? f : e;
+            e678[0] = d == h ? d : e;
+            e678[1] = (d == h && e != i) || (h == f && e != g) ? h : e;
+            e678[2] = h == f ? f : e;
+        }
+        else
+        {
+            e012[0] = e012[1] = e012[2] = e;
+            e345[0] = e345[1] = e345[2] = e;
+            e678[0] = e678[1] = e678[2] = e;
+        }
+    }
+}
+
+#ifdef GAHOOD_BOY_SIMD_X86
+
+// Picks x where mask is set and y elsewhere, the branch free form of the scalar ternaries
+GAHOOD_BOY_TARGET("sse2")
+static inline __m128i selectSse2(const __m128i mask, const __m128i x, const __m128i y)
+{
+    return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+
+GAHOOD_BOY_TARGET("sse2")
+static inline __m128i loadSse2(const Uint32 *pixels)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *> (pixels));
+}
+
+GAHOOD_BOY_TARGET("sse2")
+static inline void storeSse2(Uint32 *pixels, const __m128i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i *> (pixels), value);
+}
+
+// 2x, 3x and 4x are pure 32 bit shuffles, other factors use the scalar loop
+GAHOOD_BOY_TARGET("sse2")
+static void nearestRowSse2(const Uint32 *source, Uint32 *destination, const size width, const byte factor)
+{
+    size x = 0;
+    if(factor >= 2 && factor <= 4)
+    {
+        for(; x + 4 <= width; x += 4)
+        {
+            const __m128i pixels = loadSse2(source + x);
+            Uint32 *out = destination + x * factor;
+            if(factor == 2)
+            {
+                storeSse2(out, _mm_unpacklo_epi32(pixels, pixels));
+                storeSse2(out + 4, _mm_unpackhi_epi32(pixels, pixels));
+            }
+            else if(factor == 3)
+            {
+                storeSse2(out, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 0, 0, 0)));
+                storeSse2(out + 4, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 1, 1)));
+                storeSse2(out + 8, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 2)));
+            }
+            else
+            {
+                storeSse2(out, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 0, 0, 0)));
+                storeSse2(out + 4, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 1, 1, 1)));
+                storeSse2(out + 8, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 2, 2)));
+                storeSse2(out + 12, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 3)));
+            }
+        }
+    }
+    nearestRowScalar(source + x, destination + x * factor, width - x, factor);
+}
+
+GAHOOD_BOY_TARGET("sse2")
+static void scale2xRowSse2(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, const size width)
+{
+    size x = 0;
+    for(; x + 4 <= width; x += 4)
+    {
+        const __m128i b = loadSse2(above + x);
+        const __m128i d = loadSse2(row + x - 1);
+        const __m128i e = loadSse2(row + x);
+        const __m128i f = loadSse2(row + x + 1);
+        const __m128i h = loadSse2(below + x);
+
+        const __m128i edge = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f)), _mm_set1_epi32(-1));
+        const __m128i e0 = selectSse2(_mm_and_si128(edge, _mm_cmpeq_epi32(d, b)), d, e);
+        const __m128i e1 = selectSse2(_mm_and_si128(edge, _mm_cmpeq_epi32(b, f)), f, e);
+        const __m128i e2 = selectSse2(_mm_and_si128(edge, _mm_cmpeq_epi32(d, h)), d, e);
+        const __m128i e3 = selectSse2(_mm_and_si128(edge, _mm_cmpeq_epi32(h, f)), f, e);
+
+        storeSse2(out0 + x * 2, _mm_unpacklo_epi32(e0, e1));
+        storeSse2(out0 + x * 2 + 4, _mm_unpackhi_epi32(e0, e1));
+        storeSse2(out1 + x * 2, _mm_unpacklo_epi32(e2, e3));
+        storeSse2(out1 + x * 2 + 4, _mm_unpackhi_epi32(e2, e3));
+    }
+    scale2xRowScalar(above + x, row + x, below + x, out0 + x * 2, out1 + x * 2, width - x);
+}
+
+// Interleaves three vectors of 4 pixels into x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+GAHOOD_BOY_TARGET("sse2")
+static inline void storeInterleaved3Sse2(Uint32 *out, const __m128i x, const __m128i y, const __m128i z)
+{
+    const __m128 xf = _mm_castsi128_ps(x);
+    const __m128 yf = _mm_castsi128_ps(y);
+    const __m128 zf = _mm_castsi128_ps(z);
+    const __m128 x0y0x1y1 = _mm_castsi128_ps(_mm_unpacklo_epi32(x, y));
+    const __m128 z0z0x1x1 = _mm_shuffle_ps(zf, xf, _MM_SHUFFLE(1, 1, 0, 0));
+    const __m128 y1y1z1z1 = _mm_shuffle_ps(yf, zf, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 x2x2y2y2 = _mm_shuffle_ps(xf, yf, _MM_SHUFFLE(2, 2, 2, 2));
+    const __m128 z2z2x3x3 = _mm_shuffle_ps(zf, xf, _MM_SHUFFLE(3, 3, 2, 2));
+    const __m128 y3y3z3z3 = _mm_shuffle_ps(yf, zf, _MM_SHUFFLE(3, 3, 3, 3));
+    storeSse2(out, _mm_castps_si128(_mm_shuffle_ps(x0y0x1y1, z0z0x1x1, _MM_SHUFFLE(2, 0, 1, 0))));
+    storeSse2(out + 4, _mm_castps_si128(_mm_shuffle_ps(y1y1z1z1, x2x2y2y2, _MM_SHUFFLE(2, 0, 2, 0))));
+    storeSse2(out + 8, _mm_castps_si128(_mm_shuffle_ps(z2z2x3x3, y3y3z3z3, _MM_SHUFFLE(2, 0, 2, 0))));
+}
+
+GAHOOD_BOY_TARGET("sse2")
+static void scale3xRowSse2(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, Uint32 *out2, const size width)
+{
+    size x = 0;
+    for(; x + 4 <= width; x += 4)
+    {
+        const __m128i a = loadSse2(above + x - 1), b = loadSse2(above + x), c = loadSse2(above + x + 1);
+        const __m128i d = loadSse2(row + x - 1), e = loadSse2(row + x), f = loadSse2(row + x + 1);
+        const __m128i g = loadSse2(below + x - 1), h = loadSse2(below + x), i = loadSse2(below + x + 1);
+
+        const __m128i edge = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f)), _mm_set1_epi32(-1));
+        const __m128i db = _mm_and_si128(edge, _mm_cmpeq_epi32(d, b));
+        const __m128i bf = _mm_and_si128(edge, _mm_cmpeq_epi32(b, f));
+        const __m128i dh = _mm_and_si128(edge, _mm_cmpeq_epi32(d, h));
+        const __m128i hf = _mm_and_si128(edge, _mm_cmpeq_epi32(h, f));
+        // andnot(x == y, mask) is mask && x != y
+        const __m128i ea = _mm_cmpeq_epi32(e, a), ec = _mm_cmpeq_epi32(e, c);
+        const __m128i eg = _mm_cmpeq_epi32(e, g), ei = _mm_cmpeq_epi32(e, i);
+
+        const __m128i e0 = selectSse2(db, d, e);
+        const __m128i e1 = selectSse2(_mm_or_si128(_mm_andnot_si128(ec, db), _mm_andnot_si128(ea, bf)), b, e);
+        const __m128i e2 = selectSse2(bf, f, e);
+        const __m128i e3 = selectSse2(_mm_or_si128(_mm_andnot_si128(eg, db), _mm_andnot_si128(ea, dh)), d, e);
+        const __m128i e5 = selectSse2(_mm_or_si128(_mm_andnot_si128(ei, bf), _mm_andnot_si128(ec, hf)), f, e);
+        const __m128i e6 = selectSse2(dh, d, e);
+        const __m128i e7 = selectSse2(_mm_or_si128(_mm_andnot_si128(ei, dh), _mm_andnot_si128(eg, hf)), h, e);
+        const __m128i e8 = selectSse2(hf, f, e);
+
+        storeInterleaved3Sse2(out0 + x * 3, e0, e1, e2);
+        storeInterleaved3Sse2(out1 + x * 3, e3, e, e5);
+        storeInterleaved3Sse2(out2 + x * 3, e6, e7, e8);
+    }
+    scale3xRowScalar(above + x, row + x, below + x, out0 + x * 3, out1 + x * 3, out2 + x * 3, width - x);
+}
+
+#endif
+
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+
+// Any factor: output vector k of a block of 8 source pixels takes lane j from source pixel (8k + j) / factor
+GAHOOD_BOY_TARGET("avx2")
+static void nearestRowAvx2(const Uint32 *source, Uint32 *destination, const size width, const byte factor)
+{
+    __m256i indices[Scaler::MAX_FACTOR];
+    for(byte k = 0; k < factor; k++)
+    {
+        int lanes[8];
+        for(int j = 0; j < 8; j++)
+        {
+            lanes[j] = (8 * k + j) / factor;
+        }
+        indices[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (lanes));
+    }
+
+    size x = 0;
+    for(; x + 8 <= width; x += 8)
+    {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (source + x));
+        __m256i *out = reinterpret_cast<__m256i *> (destination + x * factor);
+        for(byte k = 0; k < factor; k++)
+        {
+            _mm256_storeu_si256(out + k, _mm256_permutevar8x32_epi32(pixels, indices[k]));
+        }
+    }
+    nearestRowScalar(source + x, destination + x * factor, width - x, factor);
+}
+
+GAHOOD_BOY_TARGET("avx2")
+static inline __m256i selectAvx2(const __m256i mask, const __m256i x, const __m256i y)
+{
+    return _mm256_blendv_epi8(y, x, mask);
+}
+
+GAHOOD_BOY_TARGET("avx2")
+static inline __m256i loadAvx2(const Uint32 *pixels)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *> (pixels));
+}
+
+// Unpacks work within 128 bit lanes, the permutes put the two halves back in pixel order
+GAHOOD_BOY_TARGET("avx2")
+static inline void storeInterleaved2Avx2(Uint32 *out, const __m256i x, const __m256i y)
+{
+    const __m256i low = _mm256_unpacklo_epi32(x, y);
+    const __m256i high = _mm256_unpackhi_epi32(x, y);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *> (out), _mm256_permute2x128_si256(low, high, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *> (out + 8), _mm256_permute2x128_si256(low, high, 0x31));
+}
+
+GAHOOD_BOY_TARGET("avx2")
+static void scale2xRowAvx2(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, const size width)
+{
+    size x = 0;
+    for(; x + 8 <= width; x += 8)
+    {
+        const __m256i b = loadAvx2(above + x);
+        const __m256i d = loadAvx2(row + x - 1);
+        const __m256i e = loadAvx2(row + x);
+        const __m256i f = loadAvx2(row + x + 1);
+        const __m256i h = loadAvx2(below + x);
+
+        const __m256i edge = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi32(b, h), _mm256_cmpeq_epi32(d, f)), _mm256_set1_epi32(-1));
+        const __m256i e0 = selectAvx2(_mm256_and_si256(edge, _mm256_cmpeq_epi32(d, b)), d, e);
+        const __m256i e1 = selectAvx2(_mm256_and_si256(edge, _mm256_cmpeq_epi32(b, f)), f, e);
+        const __m256i e2 = selectAvx2(_mm256_and_si256(edge, _mm256_cmpeq_epi32(d, h)), d, e);
+        const __m256i e3 = selectAvx2(_mm256_and_si256(edge, _mm256_cmpeq_epi32(h, f)), f, e);
+
+        storeInterleaved2Avx2(out0 + x * 2, e0, e1);
+        storeInterleaved2Avx2(out1 + x * 2, e2, e3);
+    }
+    scale2xRowScalar(above + x, row + x, below + x, out0 + x * 2, out1 + x * 2, width - x);
+}
+
+#endif
+
+static void selectNearestRow(const Uint32 *source, Uint32 *destination, const size width, const byte factor)
+{
+    nearestRowKernel = nearestRowScalar;
+#ifdef GAHOOD_BOY_SIMD_X86
+    if(Simd::hasSse2())
+    {
+        nearestRowKernel = nearestRowSse2;
+    }
+#endif
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+    if(Simd::hasAvx2())
+    {
+        nearestRowKernel = nearestRowAvx2;
+    }
+#endif
+    nearestRowKernel(source, destination, width, factor);
+}
+
+static void selectScale2xRow(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, const size width)
+{
+    scale2xRowKernel = scale2xRowScalar;
+#ifdef GAHOOD_BOY_SIMD_X86
+    if(Simd::hasSse2())
+    {
+        scale2xRowKernel = scale2xRowSse2;
+    }
+#endif
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+    if(Simd::hasAvx2())
+    {
+        scale2xRowKernel = scale2xRowAvx2;
+    }
+#endif
+    scale2xRowKernel(above, row, below, out0, out1, width);
+}
+
+static void selectScale3xRow(const Uint32 *above, const Uint32 *row, const Uint32 *below,
+    Uint32 *out0, Uint32 *out1, Uint32 *out2, const size width)
+{
+    scale3xRowKernel = scale3xRowScalar;
+#ifdef GAHOOD_BOY_SIMD_X86
+    if(Simd::hasSse2())
+    {
+        scale3xRowKernel = scale3xRowSse2;
+    }
+#endif
+    scale3xRowKernel(above, row, below, out0, out1, out2, width);
+}
@@ -0,0 +1,46 @@
+#ifndef _GAHOOD_BOY_SCALER_HPP_
+#define _GAHOOD_BOY_SCALER_HPP_
+
+#include "util.hpp"
+
+enum ScaleFilter
+{
+    SCALE_NEAREST,
+    SCALE_2X, // Scale2x (AdvMAME2x) edge smoothing, always a factor of 2
+    SCALE_3X  // Scale3x (AdvMAME3x) edge smoothing, always a factor of 3
+};
+
+/*
+* Upscales finished 160x144 RGBA8888 frames on the CPU before they are presented,
+* so the output is sharp and the same on every renderer backend. Every filter works
+* on whole scanlines with SSE2/AVX2 kernels picked at runtime.
+*/
+class Scaler
+{
+public:
+    static const byte MAX_FACTOR = 8;
+
+    Scaler(const ScaleFilter filter, const byte factor);
+    ~Scaler();
+
+    byte getFactor() const;
+    size getWidth() const;
+    size getHeight() const;
+    const Uint32 * scale(const Uint32 *pixels);
+
+    // The next scale chooses its kernels again, for the tests after a Simd::limitLevel
+    static void resetKernels();
+
+private:
+    ScaleFilter filter;
+    byte factor;
+    Uint32 *padded; // Source frame with a one pixel border repeating the edges, for the smoothing filters
+    Uint32 *scaled;
+
+    Scaler(const Scaler &other);
+    Scaler& operator=(const Scaler &other);
+
+    void pad(const Uint32 *pixels);
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _GAHOOD_BOY_SCREEN_HPP_
+#define _GAHOOD_BOY_SCREEN_HPP_
+
+#include "frame.hpp"
+
+// Where Video hands its finished frames, either the SDL Display or the HeadlessScreen
+class Screen
+{
+public:
+	virtual ~Screen() {}
+
+	virtual Frame * getBackFrame() = 0;
+	virtual void publishFrame() = 0;
+	// Frames nobody can see are not worth drawing, PPU timing goes on regardless
+	virtual bool isVisible() { return true; }
+	// Called every millisecond or so on the main thread, for screens that have to do their SDL work there
+	virtual void pumpEvents() {}
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include "simd.hpp"
+#include "util.hpp"
+
+static Simd::Level levelLimit = Simd::LEVEL_AVX2;
+
+void Simd::limitLevel(const Level level)
+{
+    levelLimit = level;
+}
+
+bool Simd::hasSse2()
+{
+#ifdef GAHOOD_BOY_SIMD_X86
+    return levelLimit >= LEVEL_SSE2 && SDL_HasSSE2() == SDL_TRUE;
+#else
+    return false;
+#endif
+}
+
+bool Simd::hasAvx2()
+{
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+    return levelLimit >= LEVEL_AVX2 && SDL_HasAVX2() == SDL_TRUE;
+#else
+    return false;
+#endif
+}
+
+bool Simd::hasBmi2()
+{
+#if defined(GAHOOD_BOY_SIMD_DISPATCH) && defined(__x86_64__)
+    // SDL has no BMI2 query
+    __builtin_cpu_init();
+    return levelLimit >= LEVEL_AVX2 && __builtin_cpu_supports("bmi2") != 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,36 @@
+#ifndef _GAHOOD_BOY_SIMD_HPP_
+#define _GAHOOD_BOY_SIMD_HPP_
+
+/*
+* x86 SIMD kernels are compiled per function with target attributes (GCC/Clang)
+* and picked at runtime, so the build itself never needs -msse4/-mavx2 flags.
+* MSVC x64 only gets the SSE2 kernels, which every x86-64 CPU has.
+*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GAHOOD_BOY_SIMD_X86
+#define GAHOOD_BOY_SIMD_DISPATCH
+#define GAHOOD_BOY_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(_M_X64)
+#define GAHOOD_BOY_SIMD_X86
+#define GAHOOD_BOY_TARGET(isa)
+#include <emmintrin.h>
+#endif
+
+namespace Simd
+{
+    enum Level
+    {
+        LEVEL_SCALAR,
+        LEVEL_SSE2,
+        LEVEL_AVX2 // AVX2 and BMI2, every CPU with one of them so far has both
+    };
+
+    // Caps what the queries below report, the kernel tests use it to force the lower kernels
+    void limitLevel(const Level level);
+    bool hasSse2();
+    bool hasAvx2();
+    bool hasBmi2();
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "tile_cache.hpp"
+#include "tile_decode.hpp"
+
+#include <cstring>
+
+static const size TILES_PER_BANK = 384;
+static const size TILE_BANKS = 2;
+static const size TILE_CACHE_SIZE = TILE_BANKS * TILES_PER_BANK * 64;
+
+static size getRowOffset(const byte bank, const address rowAddr);
+
+TileCache::TileCache()
+{
+    pixels = (byte *) calloc(TILE_CACHE_SIZE, sizeof(byte));
+    if(!pixels)
+    {
+        Gahood::criticalError("Failed to allocate the tile cache");
+    }
+}
+
+TileCache::TileCache(const TileCache &other)
+{
+    pixels = (byte *) malloc(sizeof(byte) * TILE_CACHE_SIZE);
+    if(!pixels)
+    {
+        Gahood::criticalError("Failed to allocate the tile cache");
+    }
+    memcpy(pixels, other.pixels, TILE_CACHE_SIZE);
+}
+
+TileCache& TileCache::operator=(const TileCache &other)
+{
+    if(this != &other)
+    {
+        memcpy(pixels, other.pixels, TILE_CACHE_SIZE);
+    }
+    return *this;
+}
+
+TileCache::~TileCache()
+{
+    if(pixels)
+    {
+        free(pixels);
+    }
+}
+
+void TileCache::updateRow(const byte bank, const address rowAddr, const byte lowerByte, const byte upperByte)
+{
+    TileDecoder::decodeRow(lowerByte, upperByte, pixels + getRowOffset(bank, rowAddr));
+}
+
+void TileCache::updateRows(const byte bank, const address rowAddr, const byte *tileData, const size rowCount)
+{
+    TileDecoder::decodeRows(tileData, pixels + getRowOffset(bank, rowAddr), rowCount);
+}
+
+const byte * TileCache::getRow(const byte bank, const address rowAddr) const
+{
+    return pixels + getRowOffset(bank, rowAddr);
+}
+
+// Every 2 byte row of tile data decodes to 8 bytes
+static size getRowOffset(const byte bank, const address rowAddr)
+{
+    return bank * TILES_PER_BANK * 64 + static_cast<size> ((rowAddr - 0x8000) >> 1) * 8;
+}
@@ -0,0 +1,27 @@
+#ifndef _GAHOOD_BOY_TILE_CACHE_HPP_
+#define _GAHOOD_BOY_TILE_CACHE_HPP_
+
+#include "util.hpp"
+
+/*
+* VRAM tile data (0x8000-0x97FF, 384 tiles per bank) pre-decoded into one byte
+* per pixel holding the 2-bit color index. Rows are re-decoded as VRAM is written,
+* so the renderer never has to interleave the two bit planes itself.
+*/
+class TileCache
+{
+public:
+    TileCache();
+    TileCache(const TileCache &other);
+    TileCache& operator=(const TileCache &other);
+    ~TileCache();
+
+    void updateRow(const byte bank, const address rowAddr, const byte lowerByte, const byte upperByte);
+    void updateRows(const byte bank, const address rowAddr, const byte *tileData, const size rowCount);
+    const byte * getRow(const byte bank, const address rowAddr) const;
+
+private:
+    byte *pixels;
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "tile_decode.hpp"
+#include "simd.hpp"
+
+#include <cstring>
+
+typedef void (*DecodeRowKernel)(const byte lowerByte, const byte upperByte, byte *pixels);
+typedef void (*DecodeRowsKernel)(const byte *tileData, byte *pixels, const size rowCount);
+
+static void selectDecodeRow(const byte lowerByte, const byte upperByte, byte *pixels);
+static void selectDecodeRows(const byte *tileData, byte *pixels, const size rowCount);
+
+static DecodeRowKernel decodeRowKernel = selectDecodeRow;
+static DecodeRowsKernel decodeRowsKernel = selectDecodeRows;
+
+void TileDecoder::decodeRow(const byte lowerByte, const byte upperByte, byte *pixels)
+{
+    decodeRowKernel(lowerByte, upperByte, pixels);
+}
+
+void TileDecoder::decodeRows(const byte *tileData, byte *pixels, const size rowCount)
+{
+    decodeRowsKernel(tileData, pixels, rowCount);
+}
+
+void TileDecoder::resetKernels()
+{
+    decodeRowKernel = selectDecodeRow;
+    decodeRowsKernel = selectDecodeRows;
+}
+
+static void decodeRowScalar(const byte lowerByte, const byte upperByte, byte *pixels)
+{
+    for(byte pixel = 0; pixel < 8; pixel++)
+    {
+        const byte pixelBit = 7 - pixel;
+        pixels[pixel] = static_cast<byte> ((((upperByte >> pixelBit) & 0x01) << 1) | ((lowerByte >> pixelBit) & 0x01));
+    }
+}
+
+static void decodeRowsScalar(const byte *tileData, byte *pixels, const size rowCount)
+{
+    for(size row = 0; row < rowCount; row++)
+    {
+        decodeRowScalar(tileData[row * 2], tileData[row * 2 + 1], pixels + row * 8);
+    }
+}
+
+#ifdef GAHOOD_BOY_SIMD_X86
+
+// Lane n tests bit 7 - (n % 8), so every 8 lanes expand one byte leftmost pixel first
+GAHOOD_BOY_TARGET("sse2")
+static inline __m128i decodePlanesSse2(const __m128i lower, const __m128i upper)
+{
+    const __m128i bitMask = _mm_setr_epi8(
+        static_cast<char> (0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+        static_cast<char> (0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    const __m128i lowerBits = _mm_cmpeq_epi8(_mm_and_si128(lower, bitMask), bitMask);
+    const __m128i upperBits = _mm_cmpeq_epi8(_mm_and_si128(upper, bitMask), bitMask);
+    return _mm_or_si128(_mm_and_si128(lowerBits, _mm_set1_epi8(0x01)), _mm_and_si128(upperBits, _mm_set1_epi8(0x02)));
+}
+
+GAHOOD_BOY_TARGET("sse2")
+static void decodeRowSse2(const byte lowerByte, const byte upperByte, byte *pixels)
+{
+    const __m128i decoded = decodePlanesSse2(_mm_set1_epi8(static_cast<char> (lowerByte)), _mm_set1_epi8(static_cast<char> (upperByte)));
+    _mm_storel_epi64(reinterpret_cast<__m128i *> (pixels), decoded);
+}
+
+// One tile (8 rows, 16 bytes in, 64 bytes out) per iteration
+GAHOOD_BOY_TARGET("sse2")
+static void decodeRowsSse2(const byte *tileData, byte *pixels, const size rowCount)
+{
+    const __m128i lowByteMask = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+    size row = 0;
+    for(; row + 8 <= rowCount; row += 8)
+    {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *> (tileData + row * 2));
+        // Split the interleaved planes, then widen every byte to 8 lanes: l0 x8, l1 x8, ...
+        const __m128i lower = _mm_packus_epi16(_mm_and_si128(data, lowByteMask), zero);
+        const __m128i upper = _mm_packus_epi16(_mm_srli_epi16(data, 8), zero);
+        const __m128i lower2 = _mm_unpacklo_epi8(lower, lower);
+        const __m128i upper2 = _mm_unpacklo_epi8(upper, upper);
+        const __m128i lower4Low = _mm_unpacklo_epi16(lower2, lower2);
+        const __m128i lower4High = _mm_unpackhi_epi16(lower2, lower2);
+        const __m128i upper4Low = _mm_unpacklo_epi16(upper2, upper2);
+        const __m128i upper4High = _mm_unpackhi_epi16(upper2, upper2);
+
+        __m128i *out = reinterpret_cast<__m128i *> (pixels + row * 8);
+        _mm_storeu_si128(out, decodePlanesSse2(_mm_unpacklo_epi32(lower4Low, lower4Low), _mm_unpacklo_epi32(upper4Low, upper4Low)));
+        _mm_storeu_si128(out + 1, decodePlanesSse2(_mm_unpackhi_epi32(lower4Low, lower4Low), _mm_unpackhi_epi32(upper4Low, upper4Low)));
+        _mm_storeu_si128(out + 2, decodePlanesSse2(_mm_unpacklo_epi32(lower4High, lower4High), _mm_unpacklo_epi32(upper4High, upper4High)));
+        _mm_storeu_si128(out + 3, decodePlanesSse2(_mm_unpackhi_epi32(lower4High, lower4High), _mm_unpackhi_epi32(upper4High, upper4High)));
+    }
+    decodeRowsScalar(tileData + row * 2, pixels + row * 8, rowCount - row);
+}
+
+#endif
+
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+
+// One tile per iteration, each 256 bit register covers 4 rows
+GAHOOD_BOY_TARGET("avx2")
+static void decodeRowsAvx2(const byte *tileData, byte *pixels, const size rowCount)
+{
+    const __m256i bitMask = _mm256_setr_epi8(
+        static_cast<char> (0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+        static_cast<char> (0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+        static_cast<char> (0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+        static_cast<char> (0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    // pshufb works within 128 bit lanes, so the tile is broadcast to both lanes first
+    const __m256i lowerRows0123 = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2,
+        4, 4, 4, 4, 4, 4, 4, 4, 6, 6, 6, 6, 6, 6, 6, 6);
+    const __m256i lowerRows4567 = _mm256_add_epi8(lowerRows0123, _mm256_set1_epi8(8));
+    const __m256i one = _mm256_set1_epi8(0x01);
+    const __m256i two = _mm256_set1_epi8(0x02);
+
+    size row = 0;
+    for(; row + 8 <= rowCount; row += 8)
+    {
+        const __m256i data = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *> (tileData + row * 2)));
+        __m256i *out = reinterpret_cast<__m256i *> (pixels + row * 8);
+        for(byte half = 0; half < 2; half++)
+        {
+            const __m256i lowerIndex = half == 0 ? lowerRows0123 : lowerRows4567;
+            const __m256i lower = _mm256_shuffle_epi8(data, lowerIndex);
+            const __m256i upper = _mm256_shuffle_epi8(data, _mm256_add_epi8(lowerIndex, one));
+            const __m256i lowerBits = _mm256_cmpeq_epi8(_mm256_and_si256(lower, bitMask), bitMask);
+            const __m256i upperBits = _mm256_cmpeq_epi8(_mm256_and_si256(upper, bitMask), bitMask);
+            _mm256_storeu_si256(out + half, _mm256_or_si256(_mm256_and_si256(lowerBits, one), _mm256_and_si256(upperBits, two)));
+        }
+    }
+    decodeRowsScalar(tileData + row * 2, pixels + row * 8, rowCount - row);
+}
+
+#ifdef __x86_64__
+
+// PDEP scatters the plane bits into the low two bits of each byte, the byte swap puts bit 7 first
+GAHOOD_BOY_TARGET("bmi2")
+static void decodeRowBmi2(const byte lowerByte, const byte upperByte, byte *pixels)
+{
+    const unsigned long long spread = _pdep_u64(lowerByte, 0x0101010101010101ULL) | _pdep_u64(upperByte, 0x0202020202020202ULL);
+    const unsigned long long row = __builtin_bswap64(spread);
+    memcpy(pixels, &row, sizeof(row));
+}
+
+#endif
+
+#endif
+
+static void selectDecodeRow(const byte lowerByte, const byte upperByte, byte *pixels)
+{
+    decodeRowKernel = decodeRowScalar;
+#ifdef GAHOOD_BOY_SIMD_X86
+    if(Simd::hasSse2())
+    {
+        decodeRowKernel = decodeRowSse2;
+    }
+#endif
+#if defined(GAHOOD_BOY_SIMD_DISPATCH) && defined(__x86_64__)
+    if(Simd::hasBmi2())
+    {
+        decodeRowKernel = decodeRowBmi2;
+    }
+#endif
+    decodeRowKernel(lowerByte, upperByte, pixels);
+}
+
+static void selectDecodeRows(const byte *tileData, byte *pixels, const size rowCount)
+{
+    decodeRowsKernel = decodeRowsScalar;
+#ifdef GAHOOD_BOY_SIMD_X86
+    if(Simd::hasSse2())
+    {
+        decodeRowsKernel = decodeRowsSse2;
+    }
+#endif
+#ifdef GAHOOD_BOY_SIMD_DISPATCH
+    if(Simd::hasAvx2())
+    {
+        decodeRowsKernel = decodeRowsAvx2;
+    }
+#endif
+    decodeRowsKernel(tileData, pixels, rowCount);
+}
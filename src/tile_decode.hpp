@@ -0,0 +1,20 @@
+#ifndef _GAHOOD_BOY_TILE_DECODE_HPP_
+#define _GAHOOD_BOY_TILE_DECODE_HPP_
+
+#include "util.hpp"
+
+/*
+* 2bpp tile row decoding: the lower and upper bit plane bytes of a row become
+* 8 bytes of 2-bit color indices, leftmost pixel first. The kernel (scalar,
+* SSE2, AVX2 or BMI2) is chosen on first use.
+*/
+namespace TileDecoder
+{
+    void decodeRow(const byte lowerByte, const byte upperByte, byte *pixels);
+    // tileData holds rowCount interleaved lower/upper byte pairs, exactly as in VRAM
+    void decodeRows(const byte *tileData, byte *pixels, const size rowCount);
+    // The next call chooses its kernel again, for the tests after a Simd::limitLevel
+    void resetKernels();
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include "triple_buffer.hpp"
+
+static const int FRESH_FRAME = 0x04;
+static const int FRAME_INDEX_MASK = 0x03;
+
+TripleBuffer::TripleBuffer()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		frames[i] = (Frame *) calloc(1, sizeof(Frame));
+		if (!frames[i])
+		{
+			Gahood::criticalError("Failed to allocate the frame buffers");
+		}
+	}
+	backIndex = 0;
+	SDL_AtomicSet(&middle, 1);
+	frontIndex = 2;
+}
+
+TripleBuffer::~TripleBuffer()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		free(frames[i]);
+	}
+}
+
+Frame * TripleBuffer::getBackFrame()
+{
+	return frames[backIndex];
+}
+
+void TripleBuffer::publish()
+{
+	// Every pixel store has to be visible before the consumer can pick the frame up
+	SDL_MemoryBarrierRelease();
+	backIndex = SDL_AtomicSet(&middle, backIndex | FRESH_FRAME) & FRAME_INDEX_MASK;
+}
+
+const Frame * TripleBuffer::acquire()
+{
+	if (!(SDL_AtomicGet(&middle) & FRESH_FRAME))
+	{
+		return NULL;
+	}
+	frontIndex = SDL_AtomicSet(&middle, frontIndex) & FRAME_INDEX_MASK;
+	SDL_MemoryBarrierAcquire();
+	return frames[frontIndex];
+}
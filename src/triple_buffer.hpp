@@ -0,0 +1,35 @@
+#ifndef _GAHOOD_BOY_TRIPLE_BUFFER_HPP_
+#define _GAHOOD_BOY_TRIPLE_BUFFER_HPP_
+
+#include "frame.hpp"
+
+/*
+* Lock-free hand off of frames from one producer thread to one consumer thread.
+* The producer draws into the back frame and publishes it by swapping it with the
+* middle frame, the consumer takes the middle frame in exchange for its front frame.
+* Neither side ever waits, the consumer simply always sees the newest published frame.
+*/
+class TripleBuffer
+{
+public:
+	TripleBuffer();
+	~TripleBuffer();
+
+	// Producer side
+	Frame * getBackFrame();
+	void publish();
+
+	// Consumer side, returns NULL when nothing was published since the last call
+	const Frame * acquire();
+
+private:
+	Frame *frames[3];
+	int backIndex;
+	int frontIndex;
+	SDL_atomic_t middle; // Index of the middle frame, with FRESH_FRAME set while it is unread
+
+	TripleBuffer(const TripleBuffer &other);
+	TripleBuffer& operator=(const TripleBuffer &other);
+};
+
+#endif
@@ -1,325 +1,207 @@
 #include "video.hpp"
 #include <stdio.h>
 
-Video::Video(Memory &memory)
+Video::Video(Memory &memory, Screen &screen, const byte maxFrameSkip, const bool threadedRendering) : registerSource(memory),
+	screen(screen), renderer(memory), renderQueue(renderer, screen, threadedRendering, maxFrameSkip > 0), frameSkip(maxFrameSkip)
 {
-	const unsigned int fpsMsTime = 1000 / GAHOOD_BOY_MAX_FPS;
-	renderTimer = Timer(fpsMsTime);
-	window = SDL_CreateWindow("GahoodBoy", 100, 100, 500, 500, SDL_WINDOW_OPENGL);
-	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+	drawingFrame = true;
 
-	if (!window)
-	{
-		Gahood::criticalSdlError("Failed to create the window");
-	}
-	if (!renderer)
-	{
-		Gahood::criticalSdlError("Failed to create the window renderer");
-	}
-	if (SDL_RenderSetLogicalSize(renderer, 500, 500) < 0)
-	{
-		Gahood::criticalSdlError("Failed to clip the resolution");
-	}
-	background = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, 256, 256);
-	if (!background)
-	{
-		Gahood::criticalSdlError("Failed to create the background texture");
-	}
+	statLine = false;
+	lYCoord = memory.read(0xFF44);
+	lcdStatus = memory.read(0xFF41);
+	memoryStatus = lcdStatus;
+	lcdEnabled = Gahood::bitOn(memory.read(0xFF40), 7);
+	lYCompare = memory.read(0xFF45);
 
-	if (SDL_SetRenderTarget(renderer, background) < 0)
-	{
-		Gahood::criticalSdlError("Failed to target the background texture");
-	}
-	if (SDL_RenderClear(renderer) < 0)
-	{
-		Gahood::criticalSdlError("Failed to clear the background texture");
-	}
-	if (SDL_SetRenderTarget(renderer, NULL) < 0)
-	{
-		Gahood::criticalSdlError("Failed to target the window");
-	}
-	if (SDL_RenderClear(renderer) < 0)
-	{
-		Gahood::criticalSdlError("Failed to clear the window");
-	}
-	SDL_RenderPresent(renderer);
+	// From here on VRAM, OAM and the registers are only looked at when the CPU writes them
+	memory.setVideoWriteCallback(handleVideoWrite, handleVideoBlockWrite, this);
 
 	currentClocks = 0;
 }
 
 Video::~Video()
 {
-	SDL_DestroyTexture(background);
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
+	registerSource.setVideoWriteCallback(NULL, NULL, NULL);
 }
 
 void Video::render(Memory &memory, const cycle clocks)
 {
-	refresh(memory);
-	update(memory, clocks);
+	// The clocks are CPU clocks, in CGB double speed the PPU only sees half of them
+	update(memory, memory.isDoubleSpeed() ? clocks / 2 : clocks);
 }
 
-void Video::refresh(Memory &memory)
+void Video::handleVideoWrite(void *video, const address addr, const byte byteWritten)
 {
-	const byte lcdControl = memory.read(0xFF40);
-	lcdEnabled = Gahood::bitOn(lcdControl, 7);
-	lcdWindowTileMapSelect = Gahood::bitOn(lcdControl, 6);
-	lcdWindowDisplayEnabled = Gahood::bitOn(lcdControl, 5);
-	lcdWindowBgTileSelect = Gahood::bitOn(lcdControl, 4);
-	lcdBgTileMapDisplaySelect = Gahood::bitOn(lcdControl, 3);
-	spriteSizeDetermine = Gahood::bitOn(lcdControl, 2);
-	spriteSizeDisplayEnabled = Gahood::bitOn(lcdControl, 1);
-	bgCgbDisplay = Gahood::bitOn(lcdControl, 0);
+	static_cast<Video *> (video)->write(addr, byteWritten);
+}
 
-	scrollX = memory.read(0xFF42);
-	scrollY = memory.read(0xFF43);
-	lYCoord = memory.read(0xFF44);
-	lYCompare = memory.read(0xFF45);
-	windowX = memory.read(0xFF4B) - 0x07;
-	windowY = memory.read(0xFF4A);
-	bgPallette = memory.read(0xFF47);
-	objPallette0 = memory.read(0xFF48);
-	objPallette1 = memory.read(0xFF49);
+void Video::handleVideoBlockWrite(void *video, const address addr, const byte *bytes, const size length)
+{
+	// Only VRAM DMA writes blocks, none of them touch a register Video keeps itself
+	static_cast<Video *> (video)->renderQueue.writeBlock(addr, bytes, length);
+}
 
-	lcdStatus = memory.read(0xFF41);
+void Video::write(const address addr, const byte byteWritten)
+{
+	switch (addr)
+	{
+	case 0xFF40: // LCDC, the renderer decodes the rest
+		lcdEnabled = Gahood::bitOn(byteWritten, 7);
+		break;
+	case 0xFF41: // STAT, only the interrupt enables are writable
+		lcdStatus = (byteWritten & 0x78) | (lcdStatus & 0x07);
+		memoryStatus = byteWritten;
+		return;
+	case 0xFF44: // LY is driven by the PPU itself
+		return;
+	case 0xFF45:
+		lYCompare = byteWritten;
+		return;
+	default:
+		break;
+	}
+	renderQueue.write(addr, byteWritten);
 }
+
 void Video::update(Memory &memory, const cycle clocks)
 {
 	currentClocks += clocks;
 
-	// LYC Coincidence Flag
-	if (lYCoord == lYCompare)
-	{
-		memory.write(0xFF41, lcdStatus | 0x04);
-		memory.write(0xFF0F, (memory.read(0xFF0F) | 0x02)); // Set the IF register to say we are in LCD STAT
-	}
-	else
-	{
-		memory.write(0xFF41, lcdStatus & 0xFB);
-	}
-
 	switch (lcdStatus & 0x03)
 	{
-	case 0x00: // H-Blank 201-207 clks
-		if (currentClocks >= 201)
+	case 0x00: // H-Blank 204 clks
+		if (currentClocks >= 204)
 		{
-			if (lYCoord == static_cast<byte> (143))
+			currentClocks -= 204;
+			setLine(memory, lYCoord + 1);
+			if (lYCoord == static_cast<byte> (144))
 			{
-				memory.write(0xFF41, (lcdStatus & 0xFC) | 0x01);
+				setMode(0x01);
+				requestInterrupt(memory, 0x01); // V-Blank, raised once per frame on entering mode 1
+				presentFrame();
 			}
 			else
 			{
-				memory.write(0xFF41, (lcdStatus & 0xFC) | 0x02);
+				setMode(0x02);
 			}
-			memory.write(0xFF44, lYCoord + 1);
-			currentClocks = 0;
 		}
 		break;
-	case 0x01: // V-Blank 456 clks
-	{
-		memory.write(0xFF0F, (memory.read(0xFF0F) | 0x01)); // Set the IF register to say we are in V-Blank
-		const cycle clocksToPass = 456 / (152 - 144);
-		if (lYCoord == static_cast<byte> (152))
+	case 0x01: // V-Blank 10 lines of 456 clks
+		if (currentClocks >= 456)
 		{
-			if (currentClocks < clocksToPass)
+			currentClocks -= 456;
+			if (lYCoord == static_cast<byte> (153))
 			{
-				break;
+				setLine(memory, 0);
+				setMode(0x02);
+			}
+			else
+			{
+				setLine(memory, lYCoord + 1);
 			}
-			memory.write(0xFF41, (lcdStatus & 0xFC) | 0x02);
-			memory.write(0xFF44, 0);
-			currentClocks = 0;
-		}
-		if (currentClocks >= clocksToPass)
-		{
-			memory.write(0xFF44, lYCoord + 1);
-			currentClocks = 0;
 		}
 		break;
-	}
-	case 0x02: // OAM-RAM Search 77-83 clks
-		if (currentClocks >= 77)
+	case 0x02: // OAM-RAM Search 80 clks
+		if (currentClocks >= 80)
 		{
-			memory.write(0xFF41, (lcdStatus & 0xFC) | 0x03);
+			if (lYCoord == 0x00)
+			{
+				if (frameSkip.isEnabled())
+				{
+					// Measured by the queue, so with a render thread it is that thread's time
+					frameSkip.addRenderCost(renderQueue.takeRenderCost());
+				}
+				// A hidden window skips whole frames, frameskip only judges the ones that could be seen
+				drawingFrame = screen.isVisible() && frameSkip.beginFrame();
+				if (drawingFrame)
+				{
+					renderQueue.beginFrame();
+				}
+			}
+			currentClocks -= 80;
+			setMode(0x03);
 		}
 		break;
-	case 0x03: // LCD Driver Transfer 169-175 clks
-		if (currentClocks >= 169)
+	case 0x03: // LCD Driver Transfer 172 clks
+		if (currentClocks >= 172)
 		{
-			memory.write(0xFF41, (lcdStatus & 0xFC) | 0x00);
+			currentClocks -= 172;
+			// The line is produced with the register values current at the end of the transfer
+			renderLine();
+			setMode(0x00);
+			memory.runHblankDma(); // After the line, so its VRAM writes only show from the next one
 		}
 		break;
 	default:
 		Gahood::criticalError("Undefined LCD mode %x", lcdStatus & 0x03);
 	}
-
-	if (renderTimer.checkAndReset() && lcdEnabled)
-	{
-		draw(memory);
-	}
+	updateStatLine(memory);
 }
 
-
-void Video::draw(Memory &memory) const
+void Video::updateStatLine(Memory &memory)
 {
-	byte bgTileNums[32][32];
-	address start, end;
-	if(lcdBgTileMapDisplaySelect) // 9C00-9FFF
+	// LYC Coincidence Flag
+	if (lYCoord == lYCompare)
 	{
-		start = 0x9C00;
-		end = 0x9FFF;
+		lcdStatus |= 0x04;
 	}
-	else // 9800-9BFF
+	else
 	{
-		start = 0x9800;
-		end = 0x9BFF;
+		lcdStatus &= 0xFB;
 	}
-	byte row = 0, col = 0;
-	address addr;
-	for(addr = start; addr <= end; addr += 0x01)
+	// Mode and coincidence changes are rare next to updates, unchanged STAT is not written again
+	if (lcdStatus != memoryStatus)
 	{
-		if(col != 0 && col % 32 == 0)
-		{
-			row++;
-			col = 0;
-		}
-		bgTileNums[row][col] = memory.read(addr);
-		col++;
+		memory.write(0xFF41, lcdStatus);
 	}
 
-	if (SDL_SetRenderTarget(renderer, background) < 0)
+	// The STAT interrupt line is the OR of every enabled source, only its rising edge requests an interrupt
+	const byte mode = lcdStatus & 0x03;
+	const bool line = ((lcdStatus & 0x44) == 0x44) || // LYC=LY
+		((lcdStatus & 0x08) == 0x08 && mode == 0x00) || // H-Blank
+		((lcdStatus & 0x10) == 0x10 && mode == 0x01) || // V-Blank
+		((lcdStatus & 0x20) == 0x20 && mode == 0x02); // OAM search
+	if (line && !statLine)
 	{
-		Gahood::criticalSdlError("Failed to target the background texture");
-	}
-	if (SDL_RenderClear(renderer) < 0)
-	{
-		Gahood::criticalSdlError("Failed to clear the background texture");
+		requestInterrupt(memory, 0x02);
 	}
+	statLine = line;
+}
 
-	unsigned short int bgDrawX = 0;
-	unsigned short int bgDrawY = 0;
-	for (unsigned char row = 0; row < 32; row++)
-	{
-		for (unsigned char column = 0; column < 32; column++)
-		{
-			if(bgDrawX >= 255)
-			{
-				bgDrawX = 0;
-				bgDrawY += 8;
-			}
+void Video::requestInterrupt(Memory &memory, const byte interrupt)
+{
+	memory.write(0xFF0F, memory.read(0xFF0F) | interrupt);
+}
 
-			// lcdWindowBgTileSelect == true : $8000-$8FFF with unsigned pattern
-			// else : $8800-$97FF with signed pattern
-			const address currentTile = lcdWindowBgTileSelect ?
-				0x8000 + (bgTileNums[row][column] * 16):
-				0x9000 + (static_cast<signed char> (bgTileNums[row][column]) * 16);
+void Video::setMode(const byte mode)
+{
+	// Reaches memory in updateStatLine(), at the end of the same update
+	lcdStatus = (lcdStatus & 0xFC) | mode;
+}
 
-			// draw pixels to background texture
-			for(address tileAddress = currentTile; tileAddress < currentTile + 0x0010; tileAddress += 0x0002)
-			{
-				const byte lowerPixelColor = memory.read(tileAddress);
-				const byte upperPixelColor = memory.read(tileAddress + 0x0001);
-				for(signed char pixelBit = 7; pixelBit >= 0; pixelBit--)
-				{
-					byte pixelColorSelect = 0x00;
-					if(Gahood::bitOn(upperPixelColor, pixelBit))
-					{
-						pixelColorSelect += 0x02;
-					}
-					if(Gahood::bitOn(lowerPixelColor, pixelBit))
-					{
-						pixelColorSelect += 0x01;
-					}
-					const SDL_Color pixelColor = getBgPixelColor(pixelColorSelect);
-					if(SDL_SetRenderDrawColor(renderer, pixelColor.r, pixelColor.g, pixelColor.b, pixelColor.a) < 0)
-					{
-						Gahood::criticalSdlError("Failed to set render color to pixel color (%d, %d, %d, %d)",
-							pixelColor.r, pixelColor.g, pixelColor.b, pixelColor.a);
-					}
-					if(SDL_RenderDrawPoint(renderer, bgDrawX, bgDrawY) < 0)
-					{
-						Gahood::criticalSdlError("Failed to draw pixel at %d %d", bgDrawX, bgDrawY);
-					}
-					bgDrawX++;
-				}
-				bgDrawX -= 8;
-				bgDrawY++;
-			}
-			bgDrawX += 8;
-			bgDrawY -= 8;
-		}
-	}
+void Video::setLine(Memory &memory, const byte line)
+{
+	lYCoord = line;
+	memory.write(0xFF44, lYCoord);
+}
 
-	if (SDL_SetRenderTarget(renderer, NULL) < 0)
-	{
-		Gahood::criticalSdlError("Failed to target the window");
-	}
-	if (SDL_RenderClear(renderer) < 0)
-	{
-		Gahood::criticalSdlError("Failed to clear the window");
-	}
-	if (SDL_RenderCopy(renderer, background, NULL, NULL) < 0)
+void Video::renderLine()
+{
+	if (!lcdEnabled || lYCoord >= 144 || !drawingFrame)
 	{
-		Gahood::criticalSdlError("Failed to draw the texture to the window");
+		return;
 	}
-	SDL_RenderPresent(renderer);
+
+	renderQueue.renderLine(lYCoord);
 }
 
-SDL_Color Video::getBgPixelColor(const byte pixelColorSelect) const
+void Video::presentFrame()
 {
-	byte pixelColor = 0x00;
-	switch(pixelColorSelect)
+	// Every emulated frame that was drawn is shown once, as soon as its last line is done
+	if (!lcdEnabled || !drawingFrame)
 	{
-	case 0x00:
-		pixelColor |= (bgPallette & 0x03);
-		break;
-	case 0x01:
-		pixelColor |= ((bgPallette & 0x0C) >> 2);
-		break;
-	case 0x02:
-		pixelColor |= ((bgPallette & 0x30) >> 4);
-		break;
-	case 0x03:
-		pixelColor |= ((bgPallette & 0xC0) >> 6);
-		break;
-	default:
-		Gahood::criticalError("Invalid background pixel color select %x", pixelColorSelect);
+		return;
 	}
 
-	SDL_Color color;
-	color.a = 255;
-	switch (pixelColor)
-	{
-		case 0x00: // white
-		{
-			color.r = 255;
-			color.g = 255;
-			color.b = 255;
-			break;
-		}
-		case 0x01: // light gray
-		{
-			color.r = 170;
-			color.g = 170;
-			color.b = 170;
-			break;
-		}
-		case 0x02: // dark gray
-		{
-			color.r = 85;
-			color.g = 85;
-			color.b = 85;
-			break;
-		}
-		case 0x03: // black
-		{
-			color.r = 0;
-			color.g = 0;
-			color.b = 0;
-			break;
-		}
-		default:
-			Gahood::criticalError("Invalid background pixel color %x", pixelColorSelect);
-	}
-	return color;
-}
\ No newline at end of file
+	renderQueue.present();
+}
@@ -2,48 +2,44 @@
 #define _GAHOOD_BOY_VIDEO_HPP_
 
 #include "memory.hpp"
-#include "timer.hpp"
+#include "render_queue.hpp"
+#include "frame_skip.hpp"
 
 class Video
 {
 public:
-	Video(Memory &memory);
+	Video(Memory &memory, Screen &screen, const byte maxFrameSkip, const bool threadedRendering);
 	~Video();
 
 	void render(Memory &memory, const cycle clocks);
 
 private:
-	SDL_Window *window;
-	SDL_Renderer *renderer;
-	SDL_Texture *background;
+	Memory &registerSource; // Notifies the write handlers of VRAM, OAM and LCD register writes until destruction
+	Screen &screen;
+	LineRenderer renderer;
+	RenderQueue renderQueue; // Every pixel decision goes through here, possibly to another thread
 
 	bool lcdEnabled;
-	bool lcdWindowTileMapSelect;
-	bool lcdWindowDisplayEnabled;
-	bool lcdWindowBgTileSelect;
-	bool lcdBgTileMapDisplaySelect;
-	bool spriteSizeDetermine;
-	bool spriteSizeDisplayEnabled;
-	bool bgCgbDisplay;
-
-	byte scrollX;
-	byte scrollY;
 	byte lYCoord;
 	byte lYCompare;
-	byte windowX;
-	byte windowY;
-	byte bgPallette;
-	byte objPallette0;
-	byte objPallette1;
 	byte lcdStatus;
+	byte memoryStatus; // STAT as Memory last saw it, the PPU only writes it back when the two differ
+	bool statLine; // Level of the STAT interrupt line after the last update
 
-	Timer renderTimer;
+	FrameSkip frameSkip;
+	bool drawingFrame; // False while the current frame is skipped, PPU timing still runs
 	cycle currentClocks;
 
-	void refresh(Memory &memory);
+	static void handleVideoWrite(void *video, const address addr, const byte byteWritten);
+	static void handleVideoBlockWrite(void *video, const address addr, const byte *bytes, const size length);
+	void write(const address addr, const byte byteWritten);
 	void update(Memory &memory, const cycle clocks);
-	void draw(Memory &memory) const;
-	SDL_Color getBgPixelColor(const byte pixelColorSelect) const;
+	void updateStatLine(Memory &memory);
+	void requestInterrupt(Memory &memory, const byte interrupt);
+	void setMode(const byte mode);
+	void setLine(Memory &memory, const byte line);
+	void renderLine();
+	void presentFrame();
 };
 
 #endif
\ No newline at end of file
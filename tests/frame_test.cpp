@@ -0,0 +1,83 @@
+#include "kernel_test.hpp"
+#include "frame.hpp"
+
+// The present path skips frames whose hash did not change, so any content change has to change it
+static void testHash(const Frame &frame)
+{
+    Frame *copy = (Frame *) malloc(sizeof(Frame));
+    memcpy(copy, &frame, sizeof(Frame));
+    const Uint64 hash = frame.hash();
+    if(copy->hash() != hash)
+    {
+        printf("hash: equal frames hash differently\n");
+        KernelTest::failures++;
+    }
+
+    // Every pixel, so each of the four lanes and every byte of their words is covered
+    for(size pixel = 0; pixel < sizeof(Frame::pixels); pixel++)
+    {
+        copy->pixels[pixel] ^= 0x01;
+        const bool same = copy->hash() == hash;
+        copy->pixels[pixel] ^= 0x01;
+        if(same)
+        {
+            printf("hash: changing pixel %lu keeps the hash\n", pixel);
+            KernelTest::failures++;
+            break;
+        }
+    }
+    for(byte color = 0; color < 64; color++)
+    {
+        copy->colors[color] ^= 0x100;
+        const bool same = copy->hash() == hash;
+        copy->colors[color] ^= 0x100;
+        if(same)
+        {
+            printf("hash: changing color %d keeps the hash\n", color);
+            KernelTest::failures++;
+            break;
+        }
+    }
+    free(copy);
+}
+
+// Raw pixel bytes, so the mask that keeps stray bits out of the color table is covered as well
+static void testToRgba(Frame &frame)
+{
+    const size pixelCount = sizeof(Frame::pixels);
+    Uint32 *expected = (Uint32 *) malloc(pixelCount * sizeof(Uint32));
+    Uint32 *actual = (Uint32 *) malloc(pixelCount * sizeof(Uint32));
+    KernelTest::fillRandom(frame.pixels, pixelCount);
+    for(size pixel = 0; pixel < pixelCount; pixel++)
+    {
+        expected[pixel] = frame.colors[frame.pixels[pixel] & 0x3F];
+    }
+    for(size i = 0; i < KernelTest::LEVEL_COUNT; i++)
+    {
+        Simd::limitLevel(KernelTest::LEVELS[i]);
+        Frame::resetKernels();
+        memset(actual, 0, pixelCount * sizeof(Uint32));
+        frame.toRgba(actual);
+        KernelTest::expectEqual("toRgba", KernelTest::LEVELS[i], expected, actual, pixelCount * sizeof(Uint32));
+    }
+    free(actual);
+    free(expected);
+}
+
+int main(int, char **)
+{
+    Frame *frame = (Frame *) malloc(sizeof(Frame));
+    for(size pixel = 0; pixel < sizeof(Frame::pixels); pixel++)
+    {
+        frame->pixels[pixel] = static_cast<byte> (KernelTest::nextRandom() & 0x3F);
+    }
+    for(byte color = 0; color < 64; color++)
+    {
+        frame->colors[color] = KernelTest::nextRandom();
+    }
+    testHash(*frame);
+    testToRgba(*frame);
+
+    free(frame);
+    return KernelTest::finish("frame_test");
+}
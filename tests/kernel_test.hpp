@@ -0,0 +1,60 @@
+#ifndef _GAHOOD_BOY_KERNEL_TEST_HPP_
+#define _GAHOOD_BOY_KERNEL_TEST_HPP_
+
+#include "util.hpp"
+#include "simd.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+/*
+* Helpers shared by the kernel tests. A test runs the same work once per Simd::Level
+* and compares every result with the scalar run, or with a reference written out from
+* the definition. Levels the CPU lacks fall back to a lower kernel, so they still pass,
+* they just don't test anything new.
+*/
+namespace KernelTest
+{
+    const Simd::Level LEVELS[] = { Simd::LEVEL_SCALAR, Simd::LEVEL_SSE2, Simd::LEVEL_AVX2 };
+    const char * const LEVEL_NAMES[] = { "scalar", "SSE2", "AVX2" };
+    const size LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+    static int failures = 0;
+    static Uint32 randomState = 0x2545F491; // Fixed seed, so a failure happens again on the next run
+
+    // xorshift32
+    inline Uint32 nextRandom()
+    {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return randomState;
+    }
+
+    inline void fillRandom(byte *bytes, const size count)
+    {
+        for(size i = 0; i < count; i++)
+        {
+            bytes[i] = static_cast<byte> (nextRandom());
+        }
+    }
+
+    inline bool expectEqual(const char *what, const Simd::Level level, const void *expected, const void *actual, const size length)
+    {
+        if(memcmp(expected, actual, length) == 0)
+        {
+            return true;
+        }
+        printf("%s: the %s kernel does not match\n", what, LEVEL_NAMES[level]);
+        failures++;
+        return false;
+    }
+
+    inline int finish(const char *testName)
+    {
+        printf("%s: %s\n", testName, failures == 0 ? "passed" : "FAILED");
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
+
+#endif
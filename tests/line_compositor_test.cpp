@@ -0,0 +1,82 @@
+#include "kernel_test.hpp"
+#include "line_compositor.hpp"
+
+// Random lines of every width up to past a scanline, at odd offsets so the kernels hit their scalar tails
+static const size MAX_WIDTH = 200;
+static const size LINE_RUNS = 4000;
+static const size LINE_STRIDE = MAX_WIDTH + 8;
+
+struct Lines
+{
+    byte pixels[LINE_RUNS * LINE_STRIDE];
+    byte bgIndices[LINE_RUNS * LINE_STRIDE];
+    byte sprites[LINE_RUNS * LINE_STRIDE];
+};
+
+static size runOffset(const size run)
+{
+    return run * LINE_STRIDE + run % 5;
+}
+
+static size runWidth(const size run)
+{
+    return run % (MAX_WIDTH + 1);
+}
+
+// Each flag is set about half the time, and BG color index 0 comes up often enough to matter
+static void randomLines(Lines &lines)
+{
+    KernelTest::fillRandom(lines.pixels, sizeof(lines.pixels));
+    KernelTest::fillRandom(lines.sprites, sizeof(lines.sprites));
+    for(size i = 0; i < sizeof(lines.bgIndices); i++)
+    {
+        lines.bgIndices[i] = static_cast<byte> (KernelTest::nextRandom() & 0x03);
+    }
+}
+
+static void referenceCompose(Lines &lines)
+{
+    for(size run = 0; run < LINE_RUNS; run++)
+    {
+        const size offset = runOffset(run);
+        for(size x = 0; x < runWidth(run); x++)
+        {
+            const byte sprite = lines.sprites[offset + x];
+            const bool opaque = (sprite & LineCompositor::SPRITE_OPAQUE) != 0;
+            const bool behindBg = (sprite & LineCompositor::SPRITE_BEHIND_BG) != 0;
+            if(opaque && !(behindBg && lines.bgIndices[offset + x] != 0))
+            {
+                lines.pixels[offset + x] = sprite & LineCompositor::SPRITE_PIXEL_MASK;
+            }
+        }
+    }
+}
+
+int main(int, char **)
+{
+    Lines *source = (Lines *) malloc(sizeof(Lines));
+    Lines *expected = (Lines *) malloc(sizeof(Lines));
+    Lines *actual = (Lines *) malloc(sizeof(Lines));
+    randomLines(*source);
+    memcpy(expected, source, sizeof(Lines));
+    referenceCompose(*expected);
+
+    for(size i = 0; i < KernelTest::LEVEL_COUNT; i++)
+    {
+        Simd::limitLevel(KernelTest::LEVELS[i]);
+        LineCompositor::resetKernels();
+        memcpy(actual, source, sizeof(Lines));
+        for(size run = 0; run < LINE_RUNS; run++)
+        {
+            const size offset = runOffset(run);
+            LineCompositor::compose(actual->pixels + offset, actual->bgIndices + offset, actual->sprites + offset, runWidth(run));
+        }
+        // Whole buffers, so pixels past each line's width must come out untouched too
+        KernelTest::expectEqual("compose", KernelTest::LEVELS[i], expected, actual, sizeof(Lines));
+    }
+
+    free(actual);
+    free(expected);
+    free(source);
+    return KernelTest::finish("line_compositor_test");
+}
@@ -0,0 +1,115 @@
+#include "kernel_test.hpp"
+#include "scaler.hpp"
+
+// Random 2 and 4 color frames through every filter, few colors so the smoothing rules actually fire
+static const size WIDTH = 160;
+static const size HEIGHT = 144;
+
+struct ScalerCase
+{
+    ScaleFilter filter;
+    byte factor;
+    const char *name;
+};
+
+static const ScalerCase CASES[] =
+{
+    { SCALE_NEAREST, 2, "nearest x2" },
+    { SCALE_NEAREST, 3, "nearest x3" },
+    { SCALE_NEAREST, 4, "nearest x4" },
+    { SCALE_NEAREST, 5, "nearest x5" },
+    { SCALE_NEAREST, 8, "nearest x8" },
+    { SCALE_2X, 2, "Scale2x" },
+    { SCALE_3X, 3, "Scale3x" }
+};
+static const size CASE_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+static const size MAX_SCALED = WIDTH * HEIGHT * Scaler::MAX_FACTOR * Scaler::MAX_FACTOR;
+
+// Pixels past the frame repeat the edge, like the padding the scaler builds
+static Uint32 at(const Uint32 *pixels, const long x, const long y)
+{
+    const long clampedX = x < 0 ? 0 : (x >= static_cast<long> (WIDTH) ? WIDTH - 1 : x);
+    const long clampedY = y < 0 ? 0 : (y >= static_cast<long> (HEIGHT) ? HEIGHT - 1 : y);
+    return pixels[clampedY * WIDTH + clampedX];
+}
+
+// AdvMAME2x/3x written out from the definition, one output block per source pixel
+static void referenceScale(const ScalerCase &scalerCase, const Uint32 *pixels, Uint32 *out)
+{
+    const size factor = scalerCase.factor;
+    const size outWidth = WIDTH * factor;
+    for(long y = 0; y < static_cast<long> (HEIGHT); y++)
+    {
+        for(long x = 0; x < static_cast<long> (WIDTH); x++)
+        {
+            const Uint32 a = at(pixels, x - 1, y - 1), b = at(pixels, x, y - 1), c = at(pixels, x + 1, y - 1);
+            const Uint32 d = at(pixels, x - 1, y), e = at(pixels, x, y), f = at(pixels, x + 1, y);
+            const Uint32 g = at(pixels, x - 1, y + 1), h = at(pixels, x, y + 1), i = at(pixels, x + 1, y + 1);
+            Uint32 block[9] = { e, e, e, e, e, e, e, e, e };
+            const bool edge = b != h && d != f;
+            if(scalerCase.filter == SCALE_2X && edge)
+            {
+                block[0] = d == b ? d : e;
+                block[1] = b == f ? f : e;
+                block[2] = d == h ? d : e;
+                block[3] = h == f ? f : e;
+            }
+            else if(scalerCase.filter == SCALE_3X && edge)
+            {
+                block[0] = d == b ? d : e;
+                block[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+                block[2] = b == f ? f : e;
+                block[3] = (d == b && e != g) || (d == h && e != a) ? d : e;
+                block[5] = (b == f && e != i) || (h == f && e != c) ? f : e;
+                block[6] = d == h ? d : e;
+                block[7] = (d == h && e != i) || (h == f && e != g) ? h : e;
+                block[8] = h == f ? f : e;
+            }
+            for(size blockY = 0; blockY < factor; blockY++)
+            {
+                for(size blockX = 0; blockX < factor; blockX++)
+                {
+                    const Uint32 pixel = scalerCase.filter == SCALE_NEAREST ? e : block[blockY * factor + blockX];
+                    out[(y * factor + blockY) * outWidth + x * factor + blockX] = pixel;
+                }
+            }
+        }
+    }
+}
+
+static void randomFrame(Uint32 *pixels, const Uint32 colorCount)
+{
+    static const Uint32 COLORS[4] = { 0xFFFFFFFF, 0xAAAAAAFF, 0x555555FF, 0x000000FF };
+    for(size pixel = 0; pixel < WIDTH * HEIGHT; pixel++)
+    {
+        pixels[pixel] = COLORS[KernelTest::nextRandom() % colorCount];
+    }
+}
+
+int main(int, char **)
+{
+    Uint32 *frame = (Uint32 *) malloc(WIDTH * HEIGHT * sizeof(Uint32));
+    Uint32 *expected = (Uint32 *) malloc(MAX_SCALED * sizeof(Uint32));
+
+    for(Uint32 colorCount = 2; colorCount <= 4; colorCount += 2)
+    {
+        randomFrame(frame, colorCount);
+        for(size c = 0; c < CASE_COUNT; c++)
+        {
+            const ScalerCase &scalerCase = CASES[c];
+            referenceScale(scalerCase, frame, expected);
+            const size scaledSize = WIDTH * HEIGHT * scalerCase.factor * scalerCase.factor * sizeof(Uint32);
+            for(size i = 0; i < KernelTest::LEVEL_COUNT; i++)
+            {
+                Simd::limitLevel(KernelTest::LEVELS[i]);
+                Scaler::resetKernels();
+                Scaler scaler(scalerCase.filter, scalerCase.factor);
+                KernelTest::expectEqual(scalerCase.name, KernelTest::LEVELS[i], expected, scaler.scale(frame), scaledSize);
+            }
+        }
+    }
+
+    free(expected);
+    free(frame);
+    return KernelTest::finish("scaler_test");
+}
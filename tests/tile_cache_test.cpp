@@ -0,0 +1,81 @@
+#include "kernel_test.hpp"
+#include "tile_cache.hpp"
+#include "tile_decode.hpp"
+
+// Random tile data for both banks, decoded by whole rows and by single rows at every level
+static const size TILE_DATA_SIZE = 0x1800;
+
+static byte referencePixel(const byte *tileData, const address rowAddr, const byte x)
+{
+    const address offset = static_cast<address> (rowAddr - 0x8000);
+    const byte bit = static_cast<byte> (7 - x);
+    return static_cast<byte> (((tileData[offset] >> bit) & 0x01) | (((tileData[offset + 1] >> bit) & 0x01) << 1));
+}
+
+static void checkCache(const char *what, const Simd::Level level, const TileCache &cache, const byte *banks[2])
+{
+    for(byte bank = 0; bank < 2; bank++)
+    {
+        for(address rowAddr = 0x8000; rowAddr < 0x8000 + TILE_DATA_SIZE; rowAddr += 2)
+        {
+            byte expected[8];
+            for(byte x = 0; x < 8; x++)
+            {
+                expected[x] = referencePixel(banks[bank], rowAddr, x);
+            }
+            if(!KernelTest::expectEqual(what, level, expected, cache.getRow(bank, rowAddr), sizeof(expected)))
+            {
+                return;
+            }
+        }
+    }
+}
+
+int main(int, char **)
+{
+    byte *bankData[2];
+    for(byte bank = 0; bank < 2; bank++)
+    {
+        bankData[bank] = (byte *) malloc(TILE_DATA_SIZE);
+        KernelTest::fillRandom(bankData[bank], TILE_DATA_SIZE);
+    }
+    const byte *banks[2] = { bankData[0], bankData[1] };
+
+    for(size i = 0; i < KernelTest::LEVEL_COUNT; i++)
+    {
+        const Simd::Level level = KernelTest::LEVELS[i];
+        Simd::limitLevel(level);
+        TileDecoder::resetKernels();
+
+        TileCache rows;
+        TileCache blocks;
+        for(byte bank = 0; bank < 2; bank++)
+        {
+            for(address rowAddr = 0x8000; rowAddr < 0x8000 + TILE_DATA_SIZE; rowAddr += 2)
+            {
+                const byte *row = banks[bank] + (rowAddr - 0x8000);
+                rows.updateRow(bank, rowAddr, row[0], row[1]);
+            }
+            // Odd row counts and starts, so the block kernels run into their scalar tails
+            size offset = 0;
+            while(offset < TILE_DATA_SIZE)
+            {
+                size rowCount = 1 + KernelTest::nextRandom() % 40;
+                if(offset + rowCount * 2 > TILE_DATA_SIZE)
+                {
+                    rowCount = (TILE_DATA_SIZE - offset) / 2;
+                }
+                blocks.updateRows(bank, static_cast<address> (0x8000 + offset), banks[bank] + offset, rowCount);
+                offset += rowCount * 2;
+            }
+        }
+        checkCache("updateRow", level, rows, banks);
+        checkCache("updateRows", level, blocks, banks);
+        TileCache copy(blocks);
+        checkCache("copied cache", level, copy, banks);
+    }
+
+    free(bankData[0]);
+    free(bankData[1]);
+    return KernelTest::finish("tile_cache_test");
+}
@@ -0,0 +1,82 @@
+#include "kernel_test.hpp"
+#include "tile_decode.hpp"
+
+// Every row kernel on all 65536 bit plane pairs, the block kernels on random runs at odd offsets
+static const size MAX_ROWS = 64;
+static const size BLOCK_RUNS = 2000;
+
+static void decodeAllRows(byte *pixels)
+{
+    for(size pair = 0; pair < 0x10000; pair++)
+    {
+        TileDecoder::decodeRow(static_cast<byte> (pair), static_cast<byte> (pair >> 8), pixels + pair * 8);
+    }
+}
+
+// Output one byte past the start and a sentinel after the end, so misaligned and overlong stores show up
+static void decodeBlockRuns(const byte *tileData, byte *pixels)
+{
+    for(size run = 0; run < BLOCK_RUNS; run++)
+    {
+        const size rowCount = run % (MAX_ROWS + 1);
+        const size inOffset = run % 7;
+        byte *out = pixels + run * (MAX_ROWS * 8 + 2);
+        out[1 + rowCount * 8] = 0xA5;
+        TileDecoder::decodeRows(tileData + inOffset, out + 1, rowCount);
+    }
+}
+
+// The scalar kernel itself against the bit plane definition, lower plane in bit 0
+static void checkScalarRows(const byte *pixels)
+{
+    for(size pair = 0; pair < 0x10000; pair++)
+    {
+        for(byte x = 0; x < 8; x++)
+        {
+            const byte bit = static_cast<byte> (7 - x);
+            const byte expected = static_cast<byte> (((pair >> bit) & 0x01) | (((pair >> (bit + 8)) & 0x01) << 1));
+            if(pixels[pair * 8 + x] != expected)
+            {
+                printf("decodeRow: the scalar kernel decodes %x wrong\n", static_cast<unsigned int> (pair));
+                KernelTest::failures++;
+                return;
+            }
+        }
+    }
+}
+
+int main(int, char **)
+{
+    byte *tileData = (byte *) malloc(MAX_ROWS * 2 + 8);
+    byte *expectedRows = (byte *) malloc(0x10000 * 8);
+    byte *actualRows = (byte *) malloc(0x10000 * 8);
+    byte *expectedBlocks = (byte *) calloc(BLOCK_RUNS * (MAX_ROWS * 8 + 2), 1);
+    byte *actualBlocks = (byte *) calloc(BLOCK_RUNS * (MAX_ROWS * 8 + 2), 1);
+    KernelTest::fillRandom(tileData, MAX_ROWS * 2 + 8);
+
+    Simd::limitLevel(Simd::LEVEL_SCALAR);
+    TileDecoder::resetKernels();
+    decodeAllRows(expectedRows);
+    decodeBlockRuns(tileData, expectedBlocks);
+
+    checkScalarRows(expectedRows);
+
+    for(size i = 1; i < KernelTest::LEVEL_COUNT; i++)
+    {
+        const Simd::Level level = KernelTest::LEVELS[i];
+        Simd::limitLevel(level);
+        TileDecoder::resetKernels();
+        memset(actualBlocks, 0, BLOCK_RUNS * (MAX_ROWS * 8 + 2));
+        decodeAllRows(actualRows);
+        decodeBlockRuns(tileData, actualBlocks);
+        KernelTest::expectEqual("decodeRow", level, expectedRows, actualRows, 0x10000 * 8);
+        KernelTest::expectEqual("decodeRows", level, expectedBlocks, actualBlocks, BLOCK_RUNS * (MAX_ROWS * 8 + 2));
+    }
+
+    free(actualBlocks);
+    free(expectedBlocks);
+    free(actualRows);
+    free(expectedRows);
+    free(tileData);
+    return KernelTest::finish("tile_decode_test");
+}